@@ -10,16 +10,27 @@
  *
  *--------------------------------------------------------------------------------------------------
  */
+#include <pthread.h>
+#include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <unistd.h>
 
 #include "postgres.h"
 #include "access/xact.h"													/* XactEvent																		*/
 #include "commands/defrem.h"            					/* defGetBoolean																*/
+#include "miscadmin.h"														/* CHECK_FOR_INTERRUPTS													*/
+#include "storage/proc.h"													/* StatementTimeout															*/
+#include "common/hashfn.h"												/* hash_any_extended														*/
 #include "utils/hsearch.h"												/* HTAB                               					*/
 #include "utils/syscache.h"             					/* FOREIGNSERVEROID                   					*/
 #include "utils/inval.h"                					/* CacheRegisterSyscacheCallback								*/
 #include "utils/elog.h"                 					/* ereport																			*/
+#include "utils/guc.h"														/* parse_int																		*/
+#include "utils/memutils.h"												/* TopMemoryContext															*/
+#include "utils/timestamp.h"											/* TimestampDifferenceExceeds										*/
+#include "utils/varlena.h"												/* SplitIdentifierString												*/
+#include "utils/resowner.h"												/* CurrentResourceOwner													*/
 #include "nodes/execnodes.h"            					/* ForeignScanState                   					*/
 
 #include "tibero_fdw.h"
@@ -34,112 +45,1262 @@
 #define TB_TIME_MAX_STR_SIZE 32
 #define TB_ITV_YTM_MAX_STR_SIZE 15 /* "+999999999-11" */
 #define TB_ITV_DTS_MAX_STR_SIZE 31 /* "+999999999 11:59:59.999999999" */
-#define EROWID_SGMT_LEN 6
-#define EROWID_FILE_LEN 3
-#define EROWID_BLOCK_LEN 6
-#define EROWID_ROW_LEN 3
-#define EROWID_SIZE (EROWID_SGMT_LEN + EROWID_FILE_LEN + EROWID_BLOCK_LEN + EROWID_ROW_LEN)
 /********************************************************************* Tibero datatype length }}} */
 
+#define DEFAULT_STMT_CACHE_SIZE 16
+#define DEFAULT_CIRCUIT_COOLDOWN 30
+#define DEFAULT_QUEUE_TIMEOUT 30000
+#define TB_CANCEL_POLL_INTERVAL_MS 100
+#define TB_CONN_STR_LEN 512
+
 /* {{{ Global variables ***************************************************************************/
 static HTAB *ConnectionHash = NULL;
 static bool xact_got_connection = false;
+
+/* Environment shared by all connections of the backend, allocated with the first connection */
+static SQLHANDLE tb_henv = SQL_NULL_HANDLE;
+
+/* Turn of the next round-robin endpoint when the shared state is not available */
+static uint32 local_next_endpoint = 0;
+
+/* Statement the backend is blocked on, watched by the cancel watchdog thread */
+static pthread_mutex_t watchdog_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t watchdog_cond = PTHREAD_COND_INITIALIZER;
+static bool watchdog_started = false;
+static SQLHANDLE watched_hstmt = SQL_NULL_HANDLE;
+static bool watched_cancelled = false;
 /*************************************************************************** Global variables }}} */
 
-#define TbFdwReportError(elevel, sql_errcode, msg, conn)																					 \
-do {																																															 \
-	PG_TRY();																																												 \
-	{																																																 \
-		if (conn->connected) {																																				 \
-			conn->begin_remote_xact = false;																														 \
-			conn->connected = false;																																		 \
-			/* Don't invoke tbcli wrapper function */																										 \
-			SQLDisconnect(conn->hdbc);																																	 \
-			SQLFreeHandle(SQL_HANDLE_DBC, conn->hdbc);																									 \
-			SQLFreeHandle(SQL_HANDLE_ENV, conn->henv);																									 \
-		}																																															 \
-		ereport(elevel, errcode(sql_errcode), errmsg(msg, ""));																				 \
-	}																																																 \
-	PG_FINALLY();																																										 \
-	{																																																 \
-	}																																																 \
-	PG_END_TRY();																																										 \
-} while (0)
+#define TbFdwReportError(elevel, sql_errcode, msg, conn, handle_type, handle)								 \
+	report_tb_error(elevel, sql_errcode, msg, conn, handle_type, handle)
+
+/* Login of a connection, read from the options of its server and user mapping */
+typedef struct TbLoginInfo
+{
+	const char *dbname;
+	const char *username;
+	const char *password;
+	int connect_timeout;
+} TbLoginInfo;
+
+/*
+ * Round trip run on one connection by run_concurrently, in a thread of its own that calls nothing
+ * but tbcli. Tasks embed this as their first member.
+ */
+typedef struct TbThreadTask
+{
+	void *(*worker) (void *);
+	pthread_t thread;
+	bool started;
+} TbThreadTask;
+
+/* Remote transaction of one connection ended by end_remote_xacts */
+typedef struct TbEndTranTask
+{
+	TbThreadTask task;
+	ConnCacheEntry *conn;
+	SQLSMALLINT completion_type;
+	SQLRETURN rc;
+} TbEndTranTask;
+
+/* Connection made by connect_tb_servers, trying its endpoints in order */
+typedef struct TbConnectTask
+{
+	TbThreadTask task;
+	ConnCacheEntry *conn;
+	UserMapping *user;
+	int connect_timeout;
+	int num_order;
+	int order[TB_FDW_MAX_ENDPOINTS];
+	char conn_strs[TB_FDW_MAX_ENDPOINTS][TB_CONN_STR_LEN];
+	int num_failed;
+	TbConnectError error;
+	SQLHANDLE hdbc;
+	bool connected;
+} TbConnectTask;
+
+/* TSN of one connection taken by prefetch_tb_snapshots */
+typedef struct TbSnapshotTask
+{
+	TbThreadTask task;
+	ConnCacheEntry *conn;
+	char tsn[32];
+	SQLRETURN rc;
+} TbSnapshotTask;
 
 static void TbfdwXactCallback(XactEvent event, void *arg);
 static void TbfdwSubxactCallback(SubXactEvent event, SubTransactionId mySubid,
 																 SubTransactionId parentSubid, void *arg);
 static void TbfdwInvalCallback(Datum arg, int cacheid, uint32 hashvalue);
+static bool rollback_to_tb_savepoint(ConnCacheEntry *conn, int level);
+
+static void make_tb_connection(ConnCacheEntry *conn, UserMapping *user);
+static void set_tb_connection_options(ConnCacheEntry *conn, UserMapping *user, TbLoginInfo *login);
+static void connect_tb_server(ConnCacheEntry *conn, TbLoginInfo *login);
+static ConnCacheEntry *get_tb_connection(UserMapping *user, bool use_fb_query);
+static void prepare_remote_session(ConnCacheEntry *conn, bool use_fb_query);
+static void end_remote_xacts(ConnCacheEntry **conns, int num_conns, SQLSMALLINT completion_type);
+static void *end_tran_worker(void *arg);
+static void *snapshot_worker(void *arg);
+static void run_concurrently(void *tasks, Size task_size, int num_tasks);
+static void abandon_tb_connection(ConnCacheEntry *conn);
+static void release_counted_session(ConnCacheEntry *conn);
+static bool begin_tb_connect(ConnCacheEntry *conn, bool wait);
+static void report_connect_error(ConnCacheEntry *conn);
+static void fail_tb_connect(ConnCacheEntry *conn, const char *sqlstate);
+static void save_connect_error(TbConnectError *error, SQLRETURN rc, SQLHANDLE hdbc);
+static void finish_tb_connect(ConnCacheEntry *conn);
+static void make_conn_str(char *conn_str, Size size, TbEndpoint *ep, TbLoginInfo *login);
+static bool connect_tb_endpoint(ConnCacheEntry *conn, int endpoint, TbLoginInfo *login, bool last);
+static void *connect_worker(void *arg);
+static int order_tb_endpoints(ConnCacheEntry *conn, bool read_only, int *order);
+static void set_tb_endpoints(ConnCacheEntry *conn, const char *host, const char *port,
+														 const char *hosts, const char *standby_hosts);
+static ConnCacheEntry *find_conn_cache_entry(UserMapping *user, bool create);
+static void add_conn_reference(ConnCacheEntry *conn, UserMapping *user);
+static void close_expired_tb_connections(XactEvent event);
+static void report_tb_error(int elevel, int sql_errcode, const char *msg, ConnCacheEntry *conn,
+														SQLSMALLINT handle_type, SQLHANDLE handle);
+static bool tb_connection_dead(ConnCacheEntry *conn, const char *sqlstate);
+static void discard_stmt_cache(ConnCacheEntry *conn, bool free_handles);
+static void evict_stmt_cache(ConnCacheEntry *conn);
+static void track_tb_statement(TbStatement *tbStmt);
+static void set_query_timeout(TbStatement *tbStmt);
+static void watch_tb_statement(SQLHANDLE hstmt);
+static void unwatch_tb_statement(void);
+static void *cancel_watchdog(void *arg);
+static void release_stmt_cache_in_use(ConnCacheEntry *conn);
+SQLUINTEGER get_tb_type_max_str_size(int type, SQLUINTEGER col_size, ConnCacheEntry *conn);
+SQLUINTEGER get_tb_type_from_pg_type(Oid pg_type);
+
+/*
+ * Begins the remote transaction. Autocommit is turned off once per connection when connecting, and
+ * Tibero begins a transaction with its first write. A read committed transaction therefore needs
+ * no statement here, and a serializable one only sets its isolation level.
+ */
+static void
+begin_remote_xact(TbStatement *tbStmt, bool isSerializable)
+{
+	if (isSerializable) {
+		TbSQLExecDirect(tbStmt, (SQLCHAR *)"SET TRANSACTION ISOLATION LEVEL SERIALIZABLE", SQL_NTS);
+		tbStmt->conn->xact_isolation_set = true;
+	}
+
+	tbStmt->conn->begin_remote_xact = true;
+}
+
+/*
+ * Ends the remote transactions of several connections. A transaction that neither wrote nor set
+ * its isolation level holds nothing on Tibero, so its round trip is skipped. The others are ended
+ * at once, each SQLEndTran in a thread of its own that calls nothing but tbcli, so a transaction
+ * touching several servers waits for about one round trip. Failures are reported together once
+ * every connection has finished; a failed rollback is only a warning, as the local transaction is
+ * aborting anyway. Connections are dropped only if the failure left them dead.
+ */
+static void
+end_remote_xacts(ConnCacheEntry **conns, int num_conns, SQLSMALLINT completion_type)
+{
+	TbEndTranTask *tasks = (TbEndTranTask *) palloc0(sizeof(TbEndTranTask) * num_conns);
+	StringInfoData failed;
+	int num_tasks = 0;
+	int num_failed = 0;
+	int i;
+
+	for (i = 0; i < num_conns; i++) {
+		ConnCacheEntry *conn = conns[i];
+
+		if (conn->xact_writes || conn->xact_isolation_set) {
+			tasks[num_tasks].task.worker = end_tran_worker;
+			tasks[num_tasks].conn = conn;
+			tasks[num_tasks].completion_type = completion_type;
+			num_tasks++;
+		}
+
+		conn->begin_remote_xact = false;
+		conn->xact_writes = false;
+		conn->xact_isolation_set = false;
+		conn->savepoint_level = 0;
+		conn->subxact_failed = false;
+	}
+
+	run_concurrently(tasks, sizeof(TbEndTranTask), num_tasks);
+
+	initStringInfo(&failed);
+	for (i = 0; i < num_tasks; i++) {
+		if (SQL_SUCCEEDED(tasks[i].rc))
+			continue;
+
+		appendStringInfo(&failed, "%s\"%s\"", num_failed > 0 ? ", " : "", tasks[i].conn->servername);
+		num_failed++;
+
+		/* A live connection is kept once whatever the failed commit left is rolled back */
+		if (tb_connection_dead(tasks[i].conn, "") ||
+				(completion_type == SQL_COMMIT &&
+				 !SQL_SUCCEEDED(SQLEndTran(SQL_HANDLE_DBC, tasks[i].conn->hdbc, SQL_ROLLBACK))))
+			abandon_tb_connection(tasks[i].conn);
+	}
+
+	pfree(tasks);
+
+	if (num_failed > 0)
+		ereport(completion_type == SQL_COMMIT ? ERROR : WARNING,
+						(errcode(ERRCODE_FDW_ERROR),
+						 errmsg("failed to %s remote transaction on %d of %d servers",
+										completion_type == SQL_COMMIT ? "commit" : "roll back", num_failed,
+										num_tasks),
+						 errdetail("Failed servers: %s.", failed.data)));
+
+	pfree(failed.data);
+}
+
+static void *
+end_tran_worker(void *arg)
+{
+	TbEndTranTask *task = (TbEndTranTask *) arg;
+
+	/* Don't invoke tbcli wrapper function, this may run outside the backend thread */
+	task->rc = SQLEndTran(SQL_HANDLE_DBC, task->conn->hdbc, task->completion_type);
+
+	return NULL;
+}
+
+/*
+ * Runs tasks of the given size, one thread each. A single task, or one whose thread cannot be
+ * started, runs in the backend thread instead.
+ */
+static void
+run_concurrently(void *tasks, Size task_size, int num_tasks)
+{
+	sigset_t block_all;
+	sigset_t saved;
+	int i;
+
+	if (num_tasks == 0)
+		return;
+
+	if (num_tasks == 1) {
+		TbThreadTask *task = (TbThreadTask *) tasks;
+
+		task->worker(task);
+		return;
+	}
+
+	/* Signals are left to the backend thread, the threads inherit the blocked mask */
+	sigfillset(&block_all);
+	pthread_sigmask(SIG_SETMASK, &block_all, &saved);
+	for (i = 0; i < num_tasks; i++) {
+		TbThreadTask *task = (TbThreadTask *) ((char *) tasks + i * task_size);
+
+		task->started = (pthread_create(&task->thread, NULL, task->worker, task) == 0);
+	}
+	pthread_sigmask(SIG_SETMASK, &saved, NULL);
+
+	for (i = 0; i < num_tasks; i++) {
+		TbThreadTask *task = (TbThreadTask *) ((char *) tasks + i * task_size);
+
+		if (task->started)
+			pthread_join(task->thread, NULL);
+		else
+			task->worker(task);
+	}
+}
+
+/*
+ * Makes the connections of the given user mappings that are not made yet at once, so that a
+ * statement reading from several servers waits for about one login before its scans. A connection
+ * that cannot be made is left for its scan to try again, which reports the error.
+ */
+void
+connect_tb_servers(List *users)
+{
+	TbConnectTask *tasks;
+	int num_tasks = 0;
+	int num_ready = 0;
+	ListCell *lc;
+	int i;
+
+	tasks = (TbConnectTask *) palloc0(sizeof(TbConnectTask) * list_length(users));
+
+	foreach(lc, users) {
+		UserMapping *user = (UserMapping *) lfirst(lc);
+		ConnCacheEntry *conn = find_conn_cache_entry(user, true);
+		bool listed = false;
+
+		if (conn->connected)
+			continue;
+
+		for (i = 0; i < num_tasks && !listed; i++)
+			listed = (tasks[i].conn == conn);
+		if (listed)
+			continue;
+
+		tasks[num_tasks].task.worker = connect_worker;
+		tasks[num_tasks].conn = conn;
+		tasks[num_tasks].user = user;
+		num_tasks++;
+	}
+
+	/* A single connection is made by its scan as before */
+	if (num_tasks < 2) {
+		pfree(tasks);
+		return;
+	}
+
+	/*
+	 * The plan may list tables it never scans, so a server that is failing or has no session free
+	 * right away is left to its scan rather than failing or holding up the statement here.
+	 */
+	PG_TRY();
+	{
+		for (i = 0; i < num_tasks; i++) {
+			TbConnectTask *task = &tasks[i];
+			TbLoginInfo login;
+			int j;
+
+			set_tb_connection_options(task->conn, task->user, &login);
+			if (!begin_tb_connect(task->conn, false))
+				continue;
+
+			task->connect_timeout = login.connect_timeout;
+			task->num_order = order_tb_endpoints(task->conn, XactReadOnly, task->order);
+			for (j = 0; j < task->num_order; j++)
+				make_conn_str(task->conn_strs[j], TB_CONN_STR_LEN,
+											&task->conn->endpoints[task->order[j]], &login);
+
+			if (num_ready < i)
+				memcpy(&tasks[num_ready], task, sizeof(TbConnectTask));
+			num_ready++;
+		}
+	}
+	PG_CATCH();
+	{
+		/* Nothing is connected yet, only the sessions counted are given back */
+		for (i = 0; i < num_tasks; i++)
+			release_counted_session(tasks[i].conn);
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+
+	run_concurrently(tasks, sizeof(TbConnectTask), num_ready);
+
+	for (i = 0; i < num_ready; i++) {
+		TbConnectTask *task = &tasks[i];
+		ConnCacheEntry *conn = task->conn;
+		TimestampTz now = GetCurrentTimestamp();
+		int j;
+
+		for (j = 0; j < task->num_failed; j++) {
+			conn->endpoints[task->order[j]].failures++;
+			conn->endpoints[task->order[j]].failed_at = now;
+		}
+
+		if (task->connected) {
+			conn->hdbc = task->hdbc;
+			conn->endpoint = task->order[task->num_failed];
+			finish_tb_connect(conn);
+		} else {
+			fail_tb_connect(conn, task->error.sqlstate);
+			conn->connect_error = task->error;
+			conn->connect_failed_stmt_ts = GetCurrentStatementStartTimestamp();
+		}
+	}
+
+	pfree(tasks);
+}
+
+static void *
+connect_worker(void *arg)
+{
+	TbConnectTask *task = (TbConnectTask *) arg;
+	int i;
+
+	/* Don't invoke tbcli wrapper function, this may run outside the backend thread */
+	for (i = 0; i < task->num_order; i++) {
+		SQLHANDLE hdbc = SQL_NULL_HANDLE;
+		SQLRETURN rc;
+
+		rc = SQLAllocHandle(SQL_HANDLE_DBC, task->conn->henv, &hdbc);
+		if (SQL_SUCCEEDED(rc) && task->connect_timeout > 0)
+			rc = SQLSetConnectAttr(hdbc, SQL_ATTR_LOGIN_TIMEOUT,
+														 (SQLPOINTER) (SQLULEN) task->connect_timeout, 0);
+		if (SQL_SUCCEEDED(rc))
+			rc = SQLDriverConnect(hdbc, 0, (SQLCHAR *) task->conn_strs[i], SQL_NTS, NULL, 0, NULL,
+														SQL_DRIVER_COMPLETE);
+		if (SQL_SUCCEEDED(rc)) {
+			rc = SQLSetConnectAttr(hdbc, SQL_ATTR_AUTOCOMMIT, SQL_AUTOCOMMIT_OFF, 0);
+			if (SQL_SUCCEEDED(rc)) {
+				task->hdbc = hdbc;
+				task->connected = true;
+				break;
+			}
+			SQLDisconnect(hdbc);
+		}
+
+		/* The error of the last endpoint is the one reported, as when connecting serially */
+		save_connect_error(&task->error, rc, hdbc);
+		if (hdbc != SQL_NULL_HANDLE)
+			SQLFreeHandle(SQL_HANDLE_DBC, hdbc);
+		task->num_failed++;
+	}
+
+	return NULL;
+}
+
+/*
+ * Keeps the diagnostics of a failed login. It calls nothing but tbcli, so that a thread of
+ * connect_tb_servers can use it too.
+ */
+static void
+save_connect_error(TbConnectError *error, SQLRETURN rc, SQLHANDLE hdbc)
+{
+	SQLSMALLINT len;
+
+	memset(error, 0, sizeof(TbConnectError));
+	error->rc = rc;
+
+	/* Don't invoke tbcli wrapper function */
+	if (hdbc == SQL_NULL_HANDLE ||
+			!SQL_SUCCEEDED(SQLGetDiagRec(SQL_HANDLE_DBC, hdbc, 1, (SQLCHAR *) error->sqlstate,
+																	 &error->native_error, (SQLCHAR *) error->message,
+																	 sizeof(error->message), &len)))
+		error->sqlstate[0] = '\0';
+}
+
+/*
+ * Takes the TSN for flashback queries of the current statement on the connections of the given
+ * user mappings at once, once for each connection they share, so that a statement reading from
+ * several servers waits for about one round trip before its scans. Only connections already made
+ * are considered. A failed attempt is left for the scan to repeat, which reports the error.
+ */
+void
+prefetch_tb_snapshots(List *users)
+{
+	TbSnapshotTask *tasks;
+	int num_tasks = 0;
+	ListCell *lc;
+	int i;
+
+	if (ConnectionHash == NULL)
+		return;
+
+	tasks = (TbSnapshotTask *) palloc0(sizeof(TbSnapshotTask) * list_length(users));
+
+	foreach(lc, users) {
+		ConnCacheEntry *conn = find_conn_cache_entry((UserMapping *) lfirst(lc), false);
+		bool listed = false;
+
+		if (conn == NULL || !conn->connected || conn->invalidated || !need_remote_snapshot(conn))
+			continue;
+
+		for (i = 0; i < num_tasks && !listed; i++)
+			listed = (tasks[i].conn == conn);
+		if (listed)
+			continue;
+
+		tasks[num_tasks].task.worker = snapshot_worker;
+		tasks[num_tasks].conn = conn;
+		num_tasks++;
+	}
+
+	/* A single connection takes its TSN with its scan as before */
+	if (num_tasks > 1) {
+		run_concurrently(tasks, sizeof(TbSnapshotTask), num_tasks);
+
+		for (i = 0; i < num_tasks; i++) {
+			if (!SQL_SUCCEEDED(tasks[i].rc))
+				continue;
+
+			memcpy(tasks[i].conn->tsn, tasks[i].tsn, sizeof(tasks[i].conn->tsn));
+			tasks[i].conn->stmt_ts = GetCurrentStatementStartTimestamp();
+		}
+	}
+
+	pfree(tasks);
+}
+
+static void *
+snapshot_worker(void *arg)
+{
+	TbSnapshotTask *task = (TbSnapshotTask *) arg;
+	SQLHANDLE hstmt;
+	SQLLEN len;
+
+	/* Don't invoke tbcli wrapper function, this may run outside the backend thread */
+	task->rc = SQLAllocHandle(SQL_HANDLE_STMT, task->conn->hdbc, &hstmt);
+	if (!SQL_SUCCEEDED(task->rc))
+		return NULL;
+
+	task->rc = SQLExecDirect(hstmt, (SQLCHAR *)"SELECT current_tsn FROM v$database", SQL_NTS);
+	if (SQL_SUCCEEDED(task->rc))
+		task->rc = SQLBindCol(hstmt, 1, SQL_C_CHAR, (SQLCHAR *)task->tsn, sizeof(task->tsn), &len);
+	if (SQL_SUCCEEDED(task->rc))
+		task->rc = SQLFetch(hstmt);
+
+	SQLFreeHandle(SQL_HANDLE_STMT, hstmt);
+
+	return NULL;
+}
+
+/*
+ * Reports a tbcli error with the diagnostics of the failed handle. Statement errors such as
+ * constraint violations leave the connection usable, so it is dropped only once it is dead; the
+ * remote transaction is rolled back at abort as usual.
+ */
+static void
+report_tb_error(int elevel, int sql_errcode, const char *msg, ConnCacheEntry *conn,
+								SQLSMALLINT handle_type, SQLHANDLE handle)
+{
+	SQLCHAR sqlstate[6] = "";
+	SQLCHAR message[SQL_MAX_MESSAGE_LENGTH] = "";
+	SQLINTEGER native_error = 0;
+	SQLSMALLINT len;
+	bool has_diag = false;
+
+	/* Don't invoke tbcli wrapper function */
+	if (handle != SQL_NULL_HANDLE)
+		has_diag = SQL_SUCCEEDED(SQLGetDiagRec(handle_type, handle, 1, sqlstate, &native_error, message,
+																					 sizeof(message), &len));
+
+	if (tb_connection_dead(conn, (char *) sqlstate))
+		abandon_tb_connection(conn);
+
+	if (has_diag)
+		ereport(elevel,
+						(errcode(sql_errcode),
+						 errmsg("%s", (char *) message),
+						 errdetail("tbcli %s, SQLSTATE %s, native error %d.", msg, (char *) sqlstate,
+											 (int) native_error)));
+	else
+		ereport(elevel, (errcode(sql_errcode), errmsg("%s", msg)));
+}
+
+/*
+ * Checks whether a connection that reported an error can no longer be used. A connection exception
+ * or a dead connection attribute tells so; a connection whose state cannot be read is given up too.
+ */
+static bool
+tb_connection_dead(ConnCacheEntry *conn, const char *sqlstate)
+{
+	SQLUINTEGER dead = SQL_CD_TRUE;
+
+	if (!conn->connected)
+		return false;
+
+	if (strncmp(sqlstate, "08", 2) == 0)
+		return true;
+
+	/* Don't invoke tbcli wrapper function */
+	if (!SQL_SUCCEEDED(SQLGetConnectAttr(conn->hdbc, SQL_ATTR_CONNECTION_DEAD, &dead, 0, NULL)))
+		return true;
+
+	return dead == SQL_CD_TRUE;
+}
+
+/*
+ * Forgets a connection that failed, freeing its handles without reporting further errors.
+ */
+static void
+abandon_tb_connection(ConnCacheEntry *conn)
+{
+	if (conn->connected) {
+		conn->begin_remote_xact = false;
+		conn->connected = false;
+		discard_stmt_cache(conn, false);
+		/* Don't invoke tbcli wrapper function */
+		SQLDisconnect(conn->hdbc);
+		SQLFreeHandle(SQL_HANDLE_DBC, conn->hdbc);
+		release_counted_session(conn);
+	}
+}
+
+static void
+connect_tb_server(ConnCacheEntry *conn, TbLoginInfo *login)
+{
+	int order[TB_FDW_MAX_ENDPOINTS];
+	int num_order;
+	int i;
+
+	(void) begin_tb_connect(conn, true);
+
+	num_order = order_tb_endpoints(conn, XactReadOnly, order);
+
+	PG_TRY();
+	{
+		/* The error of the last endpoint is reported when none can be connected to */
+		for (i = 0; i < num_order; i++) {
+			if (connect_tb_endpoint(conn, order[i], login, i == num_order - 1))
+				break;
+		}
+	}
+	PG_CATCH();
+	{
+		fail_tb_connect(conn, conn->connect_error.sqlstate);
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+
+	finish_tb_connect(conn);
+
+	TbSQLSetConnectAttr(conn, SQL_ATTR_AUTOCOMMIT, SQL_AUTOCOMMIT_OFF, 0);
+}
+
+/*
+ * Readies a connection to be made, here or by connect_tb_servers. A session left counted by an
+ * attempt that was interrupted is given back first. Without wait, a server whose circuit is open
+ * or that has no session free returns false, with nothing counted.
+ */
+static bool
+begin_tb_connect(ConnCacheEntry *conn, bool wait)
+{
+	Assert(conn->num_endpoints > 0 && !conn->connected);
+
+	release_counted_session(conn);
+
+	if (tb_henv == SQL_NULL_HANDLE) {
+		TbSQLAllocHandle(conn, SQL_HANDLE_ENV, SQL_NULL_HANDLE, &conn->henv);
+		TbSQLSetEnvAttr(conn, SQL_ATTR_ODBC_VERSION, (SQLPOINTER)SQL_OV_ODBC3, 0);
+		tb_henv = conn->henv;
+	}
+	conn->henv = tb_henv;
+
+	if (!wait) {
+		/* The session comes first, so that the probe of a failing server is not taken in vain */
+		if (!acquire_tb_session(conn->serverid, conn->servername, false, &conn->session_counted))
+			return false;
+		if (!check_tb_circuit(conn->serverid, conn->servername, conn->circuit_failures,
+													conn->circuit_cooldown, false)) {
+			release_counted_session(conn);
+			return false;
+		}
+		return true;
+	}
+
+	/* A server that keeps failing is not waited for until its cool-down has passed */
+	(void) check_tb_circuit(conn->serverid, conn->servername, conn->circuit_failures,
+													conn->circuit_cooldown, true);
+
+	/* Waits for a session of the server while all allowed ones are open in other backends */
+	(void) acquire_tb_session(conn->serverid, conn->servername, true, &conn->session_counted);
+
+	return true;
+}
+
+/*
+ * Reports the login that failed for the current statement in connect_tb_servers, as its
+ * connection would have.
+ */
+static void
+report_connect_error(ConnCacheEntry *conn)
+{
+	TbConnectError *error = &conn->connect_error;
+
+	if (error->sqlstate[0] != '\0')
+		ereport(ERROR,
+						(errcode(ERRCODE_FDW_UNABLE_TO_ESTABLISH_CONNECTION),
+						 errmsg("%s", error->message),
+						 errdetail("tbcli return code (%d), SQLSTATE %s, native error %d.", (int) error->rc,
+											 error->sqlstate, (int) error->native_error)));
+	else
+		ereport(ERROR,
+						(errcode(ERRCODE_FDW_UNABLE_TO_ESTABLISH_CONNECTION),
+						 errmsg("return code (%d)", (int) error->rc)));
+}
+
+/*
+ * Gives up a connection that could not be made. Only a server that could not be reached counts
+ * toward its circuit, since a rejected login of one user mapping says nothing of the server and
+ * must not lock out the others.
+ */
+static void
+fail_tb_connect(ConnCacheEntry *conn, const char *sqlstate)
+{
+	release_counted_session(conn);
+
+	if (strncmp(sqlstate, "08", 2) == 0 || strcmp(sqlstate, "HYT00") == 0)
+		report_tb_connect_result(conn->serverid, false, conn->circuit_failures, conn->circuit_cooldown);
+}
+
+/*
+ * Records a connection whose hdbc was connected to conn->endpoint.
+ */
+static void
+finish_tb_connect(ConnCacheEntry *conn)
+{
+	report_tb_connect_result(conn->serverid, true, conn->circuit_failures, conn->circuit_cooldown);
+
+	conn->connected = true;
+	conn->connect_failed_stmt_ts = 0;
+	conn->connected_at = GetCurrentTimestamp();
+	conn->last_used = conn->connected_at;
+	conn->endpoints[conn->endpoint].failures = 0;
+	if (conn->num_endpoints > 1)
+		conn->endpoint_counted = add_tb_endpoint_session(conn->serverid, conn->endpoint);
+}
+
+static void
+make_conn_str(char *conn_str, Size size, TbEndpoint *ep, TbLoginInfo *login)
+{
+	Assert(login->dbname != NULL && login->username != NULL && login->password != NULL);
+
+	snprintf(conn_str, size, "SERVER=%s;PORT=%s;DB=%s;UID=%s;PWD=%s",
+					 ep->host, ep->port, login->dbname, login->username, login->password);
+}
+
+/*
+ * Connects to one endpoint of the server. A failure is remembered in the health of the endpoint and
+ * returns false, unless the endpoint is the last one to try, whose error is raised.
+ */
+static bool
+connect_tb_endpoint(ConnCacheEntry *conn, int endpoint, TbLoginInfo *login, bool last)
+{
+	TbEndpoint *ep = &conn->endpoints[endpoint];
+	MemoryContext cctx = CurrentMemoryContext;
+	char conn_str[TB_CONN_STR_LEN] = {0,};
+	bool connected = true;
+
+	make_conn_str(conn_str, sizeof(conn_str), ep, login);
+
+	conn->hdbc = SQL_NULL_HANDLE;
+
+	PG_TRY();
+	{
+		TbSQLAllocHandle(conn, SQL_HANDLE_DBC, conn->henv, &conn->hdbc);
+		if (login->connect_timeout > 0)
+			TbSQLSetConnectAttr(conn, SQL_ATTR_LOGIN_TIMEOUT,
+													(SQLPOINTER) (SQLULEN) login->connect_timeout, 0);
+		TbSQLDriverConnect(conn, 0, (SQLCHAR *)conn_str, SQL_NTS, NULL, 0, NULL, SQL_DRIVER_COMPLETE);
+	}
+	PG_CATCH();
+	{
+		ErrorData *errdata;
+
+		ep->failures++;
+		ep->failed_at = GetCurrentTimestamp();
+
+		save_connect_error(&conn->connect_error, SQL_ERROR, conn->hdbc);
+
+		/* Don't invoke tbcli wrapper function */
+		if (conn->hdbc != SQL_NULL_HANDLE)
+			SQLFreeHandle(SQL_HANDLE_DBC, conn->hdbc);
+
+		if (last)
+			PG_RE_THROW();
+
+		MemoryContextSwitchTo(cctx);
+		errdata = CopyErrorData();
+		FlushErrorState();
+
+		ereport(LOG,
+						(errmsg("could not connect to %s:%s of server \"%s\", trying the next host",
+										ep->host, ep->port, conn->servername),
+						 errdetail_internal("%s", errdata->message)));
+		FreeErrorData(errdata);
+
+		connected = false;
+	}
+	PG_END_TRY();
+
+	if (connected)
+		conn->endpoint = endpoint;
+
+	return connected;
+}
+
+/*
+ * Orders the endpoints to try for a new connection. A read-only transaction tries the standbys
+ * first and the others after them, while a transaction that may write leaves the standbys out.
+ * Within each group host_policy picks the endpoint to start from, the rest following in the order
+ * listed, and an endpoint that failed within the cool-down of the server is tried after the others.
+ */
+static int
+order_tb_endpoints(ConnCacheEntry *conn, bool read_only, int *order)
+{
+	int num_order = 0;
+	int num_healthy;
+	int group;
+	int sessions[TB_FDW_MAX_ENDPOINTS];
+	bool have_sessions = false;
+	uint32 turn = 0;
+	TimestampTz now = GetCurrentTimestamp();
+	int i;
+
+	if (conn->host_policy == TB_HOST_LEAST_CONNECTIONS)
+		have_sessions = get_tb_endpoint_sessions(conn->serverid, sessions);
+
+	/*
+	 * A round-robin turn is taken once per connection and shared by both groups. Without the shared
+	 * state each backend starts from an endpoint of its own.
+	 */
+	if (conn->host_policy != TB_HOST_FAILOVER && !have_sessions) {
+		int next = next_tb_endpoint(conn->serverid);
+
+		turn = next >= 0 ? (uint32) next : MyProcPid + local_next_endpoint++;
+	}
+
+	for (group = 0; group < 2; group++) {
+		bool standby = read_only ? group == 0 : false;
+		int members[TB_FDW_MAX_ENDPOINTS];
+		int num_members = 0;
+		int start = 0;
+
+		if (!read_only && group == 1)
+			break;
+
+		for (i = 0; i < conn->num_endpoints; i++) {
+			if (conn->endpoints[i].standby == standby)
+				members[num_members++] = i;
+		}
+
+		if (num_members == 0)
+			continue;
+
+		if (conn->host_policy == TB_HOST_LEAST_CONNECTIONS && have_sessions) {
+			for (i = 1; i < num_members; i++) {
+				if (sessions[members[i]] < sessions[members[start]])
+					start = i;
+			}
+		} else if (conn->host_policy != TB_HOST_FAILOVER) {
+			start = turn % num_members;
+		}
+
+		for (i = 0; i < num_members; i++)
+			order[num_order++] = members[(start + i) % num_members];
+	}
+
+	/* Moves the endpoints that failed recently behind the others, keeping their order */
+	num_healthy = 0;
+	for (i = 0; i < num_order; i++) {
+		TbEndpoint *ep = &conn->endpoints[order[i]];
+
+		if (ep->failures == 0 ||
+				TimestampDifferenceExceeds(ep->failed_at, now, conn->circuit_cooldown * 1000)) {
+			int healthy = order[i];
+
+			memmove(&order[num_healthy + 1], &order[num_healthy], sizeof(int) * (i - num_healthy));
+			order[num_healthy++] = healthy;
+		}
+	}
+
+	return num_order;
+}
+
+/*
+ * Lists the endpoints of the server from its options. The health of an endpoint listed as before is
+ * kept, so that a reconnection still avoids the endpoints that failed.
+ */
+static void
+set_tb_endpoints(ConnCacheEntry *conn, const char *host, const char *port, const char *hosts,
+								 const char *standby_hosts)
+{
+	TbEndpoint endpoints[TB_FDW_MAX_ENDPOINTS];
+	int num_endpoints = 0;
+	int i;
+	int j;
+
+	Assert(host != NULL && port != NULL);
+
+	memset(endpoints, 0, sizeof(endpoints));
+	strlcpy(endpoints[0].host, host, TB_ENDPOINT_HOST_LEN);
+	strlcpy(endpoints[0].port, port, TB_ENDPOINT_PORT_LEN);
+	num_endpoints++;
+
+	for (i = 0; i < 2; i++) {
+		const char *value = (i == 0) ? hosts : standby_hosts;
+		List *host_list;
+		List *port_list;
+		ListCell *lc_host;
+		ListCell *lc_port;
+
+		if (value == NULL || !parse_tb_endpoints(value, &host_list, &port_list))
+			continue;
+
+		forboth(lc_host, host_list, lc_port, port_list) {
+			const char *ep_port = (const char *) lfirst(lc_port);
+
+			if (num_endpoints == TB_FDW_MAX_ENDPOINTS)
+				break;
+
+			strlcpy(endpoints[num_endpoints].host, (char *) lfirst(lc_host), TB_ENDPOINT_HOST_LEN);
+			strlcpy(endpoints[num_endpoints].port, ep_port != NULL ? ep_port : port,
+							TB_ENDPOINT_PORT_LEN);
+			endpoints[num_endpoints].standby = (i == 1);
+			num_endpoints++;
+		}
+	}
+
+	for (i = 0; i < num_endpoints; i++) {
+		for (j = 0; j < conn->num_endpoints; j++) {
+			TbEndpoint *old = &conn->endpoints[j];
+
+			if (strcmp(old->host, endpoints[i].host) == 0 && strcmp(old->port, endpoints[i].port) == 0 &&
+					old->standby == endpoints[i].standby) {
+				endpoints[i].failures = old->failures;
+				endpoints[i].failed_at = old->failed_at;
+				break;
+			}
+		}
+	}
+
+	memcpy(conn->endpoints, endpoints, sizeof(endpoints));
+	conn->num_endpoints = num_endpoints;
+	conn->endpoint = 0;
+}
+
+static void
+disconnect_tb_server(ConnCacheEntry *conn)
+{
+	if (conn->connected == true) {
+		/* Statement handles are freed by the disconnect */
+		discard_stmt_cache(conn, false);
+		TbSQLDisconnect(conn);
+		TbSQLFreeHandle(conn, SQL_HANDLE_DBC, conn->hdbc);
+		release_counted_session(conn);
+
+		conn->begin_remote_xact = false;
+		conn->connected = false;
+	}
+}
+
+static void
+release_counted_session(ConnCacheEntry *conn)
+{
+	if (conn->session_counted) {
+		release_tb_session(conn->serverid);
+		conn->session_counted = false;
+	}
+
+	if (conn->endpoint_counted) {
+		remove_tb_endpoint_session(conn->serverid, conn->endpoint);
+		conn->endpoint_counted = false;
+	}
+}
+
+/*
+ * A flashback query reads at the TSN taken for its statement, or at one taken for an earlier
+ * statement within tsn_reuse_interval milliseconds.
+ */
+static bool
+need_remote_snapshot(ConnCacheEntry *conn)
+{
+	TimestampTz stmt_ts = GetCurrentStatementStartTimestamp();
+
+	return !IsolationUsesXactSnapshot() && conn->stmt_ts != stmt_ts &&
+				 TimestampDifferenceExceeds(conn->stmt_ts, stmt_ts, conn->tsn_reuse_interval);
+}
+
+void
+get_tb_statement(UserMapping *user, TbStatement *tbStmt, bool use_fb_query)
+{
+	ConnCacheEntry *conn = get_tb_connection(user, use_fb_query);
+
+	tbStmt->conn = conn;
+	tbStmt->cache_entry = NULL;
+	tbStmt->query_slot_held = acquire_tb_query_slot(conn->serverid, conn->servername,
+																									conn->max_concurrent_queries,
+																									conn->queue_timeout);
+	TbSQLAllocHandle(conn, SQL_HANDLE_STMT, conn->hdbc, &tbStmt->hstmt);
+
+	memcpy(tbStmt->tsn, conn->tsn, sizeof(tbStmt->tsn));
+
+	track_tb_statement(tbStmt);
+	set_query_timeout(tbStmt);
+}
+
+/*
+ * Lists a handle that is not cached among the statements of its connection, without SQL text and
+ * in use until released, so that it is freed at abort if an error leaves it behind.
+ */
+static void
+track_tb_statement(TbStatement *tbStmt)
+{
+	TbStmtCacheEntry *entry;
+
+	entry = (TbStmtCacheEntry *) MemoryContextAllocZero(TopMemoryContext, sizeof(TbStmtCacheEntry));
+	entry->hstmt = tbStmt->hstmt;
+	entry->in_use = true;
+	dlist_push_tail(&tbStmt->conn->stmt_cache, &entry->node);
+	tbStmt->cache_entry = entry;
+}
+
+/*
+ * Lets Tibero stop a statement running past statement_timeout by itself. The timeout is in whole
+ * seconds and is set again on each use, as a cached handle outlives the setting.
+ */
+static void
+set_query_timeout(TbStatement *tbStmt)
+{
+	SQLULEN timeout = StatementTimeout > 0 ? (StatementTimeout + 999) / 1000 : 0;
+
+	TbSQLSetStmtAttr(tbStmt, SQL_ATTR_QUERY_TIMEOUT, (SQLPOINTER) timeout, 0);
+}
+
+/*
+ * Marks the statement the backend is about to block on. A cancel or termination request only sets
+ * a flag while tbcli waits for Tibero, so the watchdog thread sends SQLCancel for it. The thread is
+ * started on first use, with signals blocked so that they stay with the backend thread; without it
+ * statements are simply not cancelled.
+ */
+static void
+watch_tb_statement(SQLHANDLE hstmt)
+{
+	pthread_mutex_lock(&watchdog_lock);
+
+	if (!watchdog_started) {
+		pthread_t thread;
+		sigset_t block_all;
+		sigset_t saved;
+
+		sigfillset(&block_all);
+		pthread_sigmask(SIG_SETMASK, &block_all, &saved);
+		if (pthread_create(&thread, NULL, cancel_watchdog, NULL) == 0) {
+			pthread_detach(thread);
+			watchdog_started = true;
+		}
+		pthread_sigmask(SIG_SETMASK, &saved, NULL);
+	}
+
+	watched_hstmt = hstmt;
+	watched_cancelled = false;
+	pthread_cond_signal(&watchdog_cond);
+
+	pthread_mutex_unlock(&watchdog_lock);
+}
+
+static void
+unwatch_tb_statement(void)
+{
+	/* Waits for a cancel in progress, so the handle is not freed under it */
+	pthread_mutex_lock(&watchdog_lock);
+	watched_hstmt = SQL_NULL_HANDLE;
+	pthread_mutex_unlock(&watchdog_lock);
+}
+
+static void *
+cancel_watchdog(void *arg)
+{
+	pthread_mutex_lock(&watchdog_lock);
+
+	for (;;) {
+		if (watched_hstmt == SQL_NULL_HANDLE) {
+			pthread_cond_wait(&watchdog_cond, &watchdog_lock);
+			continue;
+		}
+
+		if (!watched_cancelled && (QueryCancelPending || ProcDiePending)) {
+			/* Don't invoke tbcli wrapper function, this runs outside the backend thread */
+			SQLCancel(watched_hstmt);
+			watched_cancelled = true;
+		}
+
+		pthread_mutex_unlock(&watchdog_lock);
+		usleep(TB_CANCEL_POLL_INTERVAL_MS * 1000L);
+		pthread_mutex_lock(&watchdog_lock);
+	}
+
+	return NULL;
+}
+
+/*
+ * Gets a statement handle with the given SQL text prepared on it. A handle left prepared for the same
+ * text on the connection is reused, so neither the handle allocation nor the parse on Tibero is
+ * repeated. The handle is given back with release_tb_statement, which keeps it in the cache of the
+ * connection.
+ */
+void
+get_tb_prepared_statement(UserMapping *user, TbStatement *tbStmt, bool use_fb_query, char *sql)
+{
+	ConnCacheEntry *conn = get_tb_connection(user, use_fb_query);
+	TbStmtCacheEntry *entry = NULL;
+	dlist_iter iter;
+
+	tbStmt->conn = conn;
+	tbStmt->cache_entry = NULL;
+	memcpy(tbStmt->tsn, conn->tsn, sizeof(tbStmt->tsn));
+	tbStmt->query_slot_held = acquire_tb_query_slot(conn->serverid, conn->servername,
+																									conn->max_concurrent_queries,
+																									conn->queue_timeout);
+
+	dlist_foreach(iter, &conn->stmt_cache) {
+		TbStmtCacheEntry *cur = dlist_container(TbStmtCacheEntry, node, iter.cur);
+
+		if (!cur->in_use && cur->sql != NULL && strcmp(cur->sql, sql) == 0) {
+			entry = cur;
+			break;
+		}
+	}
+
+	if (entry != NULL) {
+		dlist_move_head(&conn->stmt_cache, &entry->node);
+		entry->in_use = true;
+		tbStmt->hstmt = entry->hstmt;
+		tbStmt->cache_entry = entry;
+		set_query_timeout(tbStmt);
+		return;
+	}
+
+	TbSQLAllocHandle(conn, SQL_HANDLE_STMT, conn->hdbc, &tbStmt->hstmt);
+	track_tb_statement(tbStmt);
+	set_query_timeout(tbStmt);
+	TbSQLPrepare(tbStmt, (SQLCHAR *) sql, SQL_NTS);
+
+	if (conn->stmt_cache_size > 0) {
+		entry = tbStmt->cache_entry;
+		entry->sql = MemoryContextStrdup(TopMemoryContext, sql);
+		dlist_move_head(&conn->stmt_cache, &entry->node);
+		conn->stmt_cache_cnt++;
+
+		evict_stmt_cache(conn);
+	}
+}
+
+/*
+ * Gives back a statement handle. A cached handle is closed and its bindings are reset, so that the
+ * next user can bind its own buffers; any other handle is dropped.
+ */
+void
+release_tb_statement(TbStatement *tbStmt)
+{
+	TbStmtCacheEntry *entry = tbStmt->cache_entry;
+
+	if (tbStmt->query_slot_held) {
+		release_tb_query_slot(tbStmt->conn->serverid);
+		tbStmt->query_slot_held = false;
+	}
+
+	if (entry == NULL) {
+		TbSQLFreeStmt(tbStmt, SQL_DROP);
+		return;
+	}
 
-static void make_tb_connection(ConnCacheEntry *conn, UserMapping *user);
-SQLUINTEGER get_tb_type_max_str_size(int type, SQLUINTEGER col_size, ConnCacheEntry *conn);
-SQLUINTEGER get_tb_type_from_pg_type(Oid pg_type);
+	tbStmt->cache_entry = NULL;
 
-static void
-begin_remote_xact(TbStatement *tbStmt, bool isSerializable)
-{
-	TbSQLSetConnectAttr(tbStmt->conn, SQL_ATTR_AUTOCOMMIT, SQL_AUTOCOMMIT_OFF, 0);
+	/* The handle was freed with its connection */
+	if (entry->detached) {
+		if (entry->sql != NULL)
+			pfree(entry->sql);
+		pfree(entry);
+		return;
+	}
 
-	if (isSerializable) {
-		TbSQLExecDirect(tbStmt, (SQLCHAR *)"SET TRANSACTION ISOLATION LEVEL SERIALIZABLE", SQL_NTS);
-	} else {
-		TbSQLExecDirect(tbStmt, (SQLCHAR *)"SET TRANSACTION ISOLATION LEVEL READ COMMITTED", SQL_NTS);
+	if (entry->sql == NULL) {
+		dlist_delete(&entry->node);
+		pfree(entry);
+		TbSQLFreeStmt(tbStmt, SQL_DROP);
+		return;
 	}
 
-	tbStmt->conn->begin_remote_xact = true;
+	TbSQLFreeStmt(tbStmt, SQL_CLOSE);
+	TbSQLFreeStmt(tbStmt, SQL_UNBIND);
+	TbSQLFreeStmt(tbStmt, SQL_RESET_PARAMS);
+	entry->in_use = false;
+
+	evict_stmt_cache(tbStmt->conn);
 }
 
+/*
+ * Drops the least recently used handles not in use until the cache fits its size.
+ */
 static void
-connect_tb_server(ConnCacheEntry *conn, const char *host, const char *port, const char *dbname,
-									const char *username, const char *password)
+evict_stmt_cache(ConnCacheEntry *conn)
 {
-	char conn_str[512] = {0,};
+	dlist_mutable_iter iter;
 
-	Assert(host != NULL && port != NULL && dbname != NULL && username != NULL && password != NULL);
+	dlist_reverse_foreach_modify(iter, &conn->stmt_cache) {
+		TbStmtCacheEntry *entry = dlist_container(TbStmtCacheEntry, node, iter.cur);
 
-	snprintf(conn_str, sizeof(conn_str), "SERVER=%s;PORT=%s;DB=%s;UID=%s;PWD=%s",
-					 host, port, dbname, username, password);
+		if (conn->stmt_cache_cnt <= conn->stmt_cache_size)
+			break;
 
-	TbSQLAllocHandle(conn, SQL_HANDLE_ENV, SQL_NULL_HANDLE, &conn->henv);
-	TbSQLSetEnvAttr(conn, SQL_ATTR_ODBC_VERSION, (SQLPOINTER)SQL_OV_ODBC3, 0);
+		if (entry->in_use)
+			continue;
 
-	TbSQLAllocHandle(conn, SQL_HANDLE_DBC, conn->henv, &conn->hdbc);
-	TbSQLDriverConnect(conn, 0, (SQLCHAR *)conn_str, SQL_NTS, NULL, 0, NULL, SQL_DRIVER_COMPLETE);
+		dlist_delete(&entry->node);
+		conn->stmt_cache_cnt--;
 
-	conn->connected = true;
+		TbSQLFreeHandle(conn, SQL_HANDLE_STMT, entry->hstmt);
+		pfree(entry->sql);
+		pfree(entry);
+	}
 }
 
+/*
+ * Empties the statement cache of a connection. Handles are freed only if asked, since disconnecting
+ * frees them anyway.
+ */
 static void
-disconnect_tb_server(ConnCacheEntry *conn)
+discard_stmt_cache(ConnCacheEntry *conn, bool free_handles)
 {
-	if (conn->connected == true) {
-		TbSQLDisconnect(conn);
-		TbSQLFreeHandle(conn, SQL_HANDLE_DBC, conn->hdbc);
-		TbSQLFreeHandle(conn, SQL_HANDLE_ENV, conn->henv);
+	dlist_mutable_iter iter;
 
-		conn->begin_remote_xact = false;
-		conn->connected = false;
+	dlist_foreach_modify(iter, &conn->stmt_cache) {
+		TbStmtCacheEntry *entry = dlist_container(TbStmtCacheEntry, node, iter.cur);
+
+		dlist_delete(&entry->node);
+
+		if (entry->in_use) {
+			entry->detached = true;
+			continue;
+		}
+
+		if (free_handles) {
+			/* Don't invoke tbcli wrapper function */
+			SQLFreeHandle(SQL_HANDLE_STMT, entry->hstmt);
+		}
+		pfree(entry->sql);
+		pfree(entry);
 	}
+
+	conn->stmt_cache_cnt = 0;
 }
 
-static bool
-need_remote_snapshot(ConnCacheEntry *conn)
+/*
+ * Frees the handles still in use at the end of a transaction. Their scan or modify was aborted
+ * before giving them back, so the state of the handle is unknown.
+ */
+static void
+release_stmt_cache_in_use(ConnCacheEntry *conn)
 {
-	return !IsolationUsesXactSnapshot() &&
-				 (conn->stmt_ts != GetCurrentStatementStartTimestamp());
+	dlist_mutable_iter iter;
+
+	dlist_foreach_modify(iter, &conn->stmt_cache) {
+		TbStmtCacheEntry *entry = dlist_container(TbStmtCacheEntry, node, iter.cur);
+
+		if (!entry->in_use)
+			continue;
+
+		dlist_delete(&entry->node);
+
+		/* Don't invoke tbcli wrapper function, the transaction may be aborting */
+		SQLFreeHandle(SQL_HANDLE_STMT, entry->hstmt);
+		if (entry->sql != NULL) {
+			conn->stmt_cache_cnt--;
+			pfree(entry->sql);
+		}
+		pfree(entry);
+	}
 }
 
-void
-get_tb_statement(UserMapping *user, TbStatement *tbStmt, bool use_fb_query)
+/*
+ * Finds the connection of the user mapping, adding it when create is set. The key holds a hash of
+ * the credentials, so an entry is taken only when its own credentials are the same; a login whose
+ * credentials hash the same goes on to the next entry of the chain.
+ */
+static ConnCacheEntry *
+find_conn_cache_entry(UserMapping *user, bool create)
 {
-	bool found = false;
-	bool retry = false;
-	ConnCacheEntry *conn;
 	ConnCacheKey key;
-	MemoryContext cctx = CurrentMemoryContext;
+	ConnCacheEntry *conn = NULL;
+	StringInfoData credentials;
+	const char *username = "";
+	const char *password = "";
+	ListCell *lc;
 
 	if (ConnectionHash == NULL) {
 		HASHCTL ctl;
+
+		if (!create)
+			return NULL;
+
 		ctl.keysize = sizeof(ConnCacheKey);
 		ctl.entrysize = sizeof(ConnCacheEntry);
 		ConnectionHash = hash_create("tibero_fdw connections", 8, &ctl, HASH_ELEM|HASH_BLOBS);
@@ -150,45 +1311,187 @@ get_tb_statement(UserMapping *user, TbStatement *tbStmt, bool use_fb_query)
 		CacheRegisterSyscacheCallback(USERMAPPINGOID, TbfdwInvalCallback, (Datum) 0);
 	}
 
-	xact_got_connection = true;
+	foreach(lc, user->options) {
+		DefElem *def = (DefElem *) lfirst(lc);
+		if (strcmp(def->defname, "username") == 0) {
+			username = defGetString(def);
+		} else if (strcmp(def->defname, "password") == 0) {
+			password = defGetString(def);
+		}
+	}
 
-	key = user->umid;
-	conn = hash_search(ConnectionHash, &key, HASH_ENTER, &found);
-	if (!found) {
-		conn->connected = false;
+	initStringInfo(&credentials);
+	appendStringInfoString(&credentials, username);
+	appendStringInfoChar(&credentials, '\0');
+	appendStringInfoString(&credentials, password);
+
+	/* Padding is compared with the key, so it is cleared */
+	memset(&key, 0, sizeof(key));
+	key.serverid = user->serverid;
+	key.credentials_hash = DatumGetUInt64(hash_any_extended((unsigned char *) credentials.data,
+																													credentials.len, 0));
+
+	/* Entries are never removed, so the chain of a hash has no gaps */
+	for (key.collision = 0;; key.collision++) {
+		bool found;
+
+		conn = hash_search(ConnectionHash, &key, create ? HASH_ENTER : HASH_FIND, &found);
+		if (conn == NULL)
+			break;
+
+		if (!found) {
+			conn->credentials = MemoryContextAlloc(TopMemoryContext, credentials.len);
+			memcpy(conn->credentials, credentials.data, credentials.len);
+			conn->credentials_len = credentials.len;
+			conn->connected = false;
+			conn->session_counted = false;
+			conn->endpoint_counted = false;
+			conn->connect_failed_stmt_ts = 0;
+			conn->num_endpoints = 0;
+			conn->mapping_hashvalues = NIL;
+			dlist_init(&conn->stmt_cache);
+			conn->stmt_cache_cnt = 0;
+			break;
+		}
+
+		if (conn->credentials_len == credentials.len &&
+				memcmp(conn->credentials, credentials.data, credentials.len) == 0)
+			break;
 	}
-	tbStmt->conn = conn;
+	pfree(credentials.data);
+
+	return conn;
+}
+
+/*
+ * Notes the user mapping among those sharing the connection, so that a change to any of them
+ * invalidates it.
+ */
+static void
+add_conn_reference(ConnCacheEntry *conn, UserMapping *user)
+{
+	uint32 hashvalue = GetSysCacheHashValue1(USERMAPPINGOID, ObjectIdGetDatum(user->umid));
+	MemoryContext oldcxt;
+
+	if (list_member_int(conn->mapping_hashvalues, (int) hashvalue))
+		return;
+
+	oldcxt = MemoryContextSwitchTo(TopMemoryContext);
+	conn->mapping_hashvalues = lappend_int(conn->mapping_hashvalues, (int) hashvalue);
+	MemoryContextSwitchTo(oldcxt);
+}
+
+/*
+ * Connects to the listed servers with the user mappings of the session user, so that the first
+ * query of the session does not wait for the login. Only a library loaded at session start, through
+ * session_preload_libraries, connects ahead; one loaded by a query connects on use as before. A
+ * server that cannot be connected to is reported as a warning and left to connect on use.
+ */
+void
+preconnect_tb_servers(const char *servers)
+{
+	MemoryContext callercxt = CurrentMemoryContext;
+	MemoryContext xactcxt;
+	char *rawstring;
+	List *names;
+	ListCell *lc;
+
+	if (servers == NULL || servers[0] == '\0')
+		return;
+
+	if (IsBackgroundWorker || !OidIsValid(MyDatabaseId) || IsTransactionState())
+		return;
+
+	StartTransactionCommand();
+	xactcxt = CurrentMemoryContext;
+
+	rawstring = pstrdup(servers);
+	if (!SplitIdentifierString(rawstring, ',', &names)) {
+		ereport(WARNING,
+						(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+						 errmsg("invalid list syntax in parameter \"%s\"", "tibero_fdw.preconnect_servers")));
+		names = NIL;
+	}
+
+	foreach(lc, names) {
+		char *servername = (char *) lfirst(lc);
+		ResourceOwner oldowner = CurrentResourceOwner;
+
+		BeginInternalSubTransaction(NULL);
+		PG_TRY();
+		{
+			ForeignServer *server = GetForeignServerByName(servername, false);
+			UserMapping *user = GetUserMapping(GetUserId(), server->serverid);
+			ConnCacheEntry *conn = find_conn_cache_entry(user, true);
+
+			if (!conn->connected)
+				make_tb_connection(conn, user);
+			add_conn_reference(conn, user);
+
+			ReleaseCurrentSubTransaction();
+		}
+		PG_CATCH();
+		{
+			ErrorData *errdata;
+
+			MemoryContextSwitchTo(xactcxt);
+			errdata = CopyErrorData();
+			FlushErrorState();
+			RollbackAndReleaseCurrentSubTransaction();
+
+			ereport(WARNING,
+							(errcode(errdata->sqlerrcode),
+							 errmsg("could not connect ahead to server \"%s\"", servername),
+							 errdetail_internal("%s", errdata->message)));
+			FreeErrorData(errdata);
+		}
+		PG_END_TRY();
+
+		MemoryContextSwitchTo(xactcxt);
+		CurrentResourceOwner = oldowner;
+	}
+
+	CommitTransactionCommand();
+	MemoryContextSwitchTo(callercxt);
+}
+
+static ConnCacheEntry *
+get_tb_connection(UserMapping *user, bool use_fb_query)
+{
+	bool retry = false;
+	ConnCacheEntry *conn;
+	MemoryContext cctx = CurrentMemoryContext;
+
+	conn = find_conn_cache_entry(user, true);
+
+	xact_got_connection = true;
 
 	PG_TRY();
 	{
 		if (conn->connected && conn->invalidated)
 			disconnect_tb_server(conn);
 
-		if (conn->connected == false)
-			make_tb_connection(conn, user);
-
-		TbSQLAllocHandle(conn, SQL_HANDLE_STMT, conn->hdbc, &tbStmt->hstmt);
+		/* A standby serves read-only transactions only, so others connect again to a primary */
+		if (conn->connected && !conn->begin_remote_xact && !XactReadOnly &&
+				conn->endpoints[conn->endpoint].standby)
+			disconnect_tb_server(conn);
 
-		if (conn->begin_remote_xact == false)
-			begin_remote_xact(tbStmt, IsolationUsesXactSnapshot());
+		/* A connection lost while idle is found before the transaction uses it */
+		if (conn->connected && !conn->begin_remote_xact && tb_connection_dead(conn, ""))
+			abandon_tb_connection(conn);
 
-		if (use_fb_query && need_remote_snapshot(conn)) {
-			SQLUINTEGER len;
-			TbSQLExecDirect(tbStmt, (SQLCHAR *)"SELECT current_tsn FROM v$database", SQL_NTS);
-			TbSQLBindCol(tbStmt, 1, SQL_C_CHAR, (SQLCHAR *)conn->tsn, sizeof(conn->tsn), (long *)&len);
-			TbSQLFetch(tbStmt, NULL, NULL);
-			TbSQLFreeStmt(tbStmt, SQL_CLOSE);
-			conn->stmt_ts = GetCurrentStatementStartTimestamp();
-		}
+		if (conn->connected == false)
+			make_tb_connection(conn, user);
 
-		memcpy(tbStmt->tsn, conn->tsn, sizeof(tbStmt->tsn));
+		prepare_remote_session(conn, use_fb_query);
 	}
 	PG_CATCH();
 	{
 		MemoryContext ectx = MemoryContextSwitchTo(cctx);
 		ErrorData	*errdata = CopyErrorData();
 
-		if (errdata->sqlerrcode != ERRCODE_FDW_ERROR) {
+		/* A statement error leaves the connection alive, only a lost one is made again */
+		if (errdata->sqlerrcode != ERRCODE_FDW_ERROR || conn->connected) {
 			MemoryContextSwitchTo(ectx);
 			PG_RE_THROW();
 		}
@@ -202,34 +1505,105 @@ get_tb_statement(UserMapping *user, TbStatement *tbStmt, bool use_fb_query)
 	PG_END_TRY();
 
 	if (retry) {
-		disconnect_tb_server(conn);
 		make_tb_connection(conn, user);
-		TbSQLAllocHandle(conn, SQL_HANDLE_STMT, conn->hdbc, &tbStmt->hstmt);
-		begin_remote_xact(tbStmt, IsolationUsesXactSnapshot());
+		prepare_remote_session(conn, use_fb_query);
+	}
+
+	add_conn_reference(conn, user);
+
+	return conn;
+}
+
+/*
+ * Begins the remote transaction and takes the TSN of a flashback query when needed. They run on a
+ * handle of their own, so that a cached statement handle keeps its prepared statement.
+ */
+static void
+prepare_remote_session(ConnCacheEntry *conn, bool use_fb_query)
+{
+	TbStatement tbStmt;
+	bool need_snapshot = use_fb_query && need_remote_snapshot(conn);
+
+	/* A read committed transaction begins without a statement */
+	if (!conn->begin_remote_xact && !IsolationUsesXactSnapshot())
+		conn->begin_remote_xact = true;
+
+	if (conn->begin_remote_xact && !need_snapshot)
+		return;
+
+	memset(&tbStmt, 0, sizeof(tbStmt));
+	tbStmt.conn = conn;
+	TbSQLAllocHandle(conn, SQL_HANDLE_STMT, conn->hdbc, &tbStmt.hstmt);
+	track_tb_statement(&tbStmt);
+
+	if (conn->begin_remote_xact == false)
+		begin_remote_xact(&tbStmt, IsolationUsesXactSnapshot());
+
+	if (need_snapshot) {
+		SQLUINTEGER len;
+		TbSQLExecDirect(&tbStmt, (SQLCHAR *)"SELECT current_tsn FROM v$database", SQL_NTS);
+		TbSQLBindCol(&tbStmt, 1, SQL_C_CHAR, (SQLCHAR *)conn->tsn, sizeof(conn->tsn), (long *)&len);
+		TbSQLFetch(&tbStmt, NULL, NULL);
+		conn->stmt_ts = GetCurrentStatementStartTimestamp();
 	}
+
+	release_tb_statement(&tbStmt);
 }
 
 static void
 make_tb_connection(ConnCacheEntry *conn, UserMapping *user)
+{
+	TbLoginInfo login;
+
+	Assert(conn->connected == false);
+
+	/* A login that failed for the statement in connect_tb_servers is not tried again */
+	if (conn->connect_failed_stmt_ts == GetCurrentStatementStartTimestamp())
+		report_connect_error(conn);
+
+	set_tb_connection_options(conn, user, &login);
+	connect_tb_server(conn, &login);
+}
+
+/*
+ * Sets up a connection not made yet from the options of its server and user mapping, returning
+ * what it logs in with.
+ */
+static void
+set_tb_connection_options(ConnCacheEntry *conn, UserMapping *user, TbLoginInfo *login)
 {
 	ForeignServer *server = GetForeignServer(user->serverid);
 	ListCell	 *lc;
 	const char *host = NULL;
 	const char *port = NULL;
-	const char *dbname = NULL;
-	const char *username = NULL;
-	const char *password = NULL;
+	const char *hosts = NULL;
+	const char *standby_hosts = NULL;
 
-	Assert(conn->connected == false);
+	memset(login, 0, sizeof(TbLoginInfo));
 
 	conn->serverid = server->serverid;
+	strlcpy(conn->servername, server->servername, NAMEDATALEN);
 	conn->server_hashvalue = GetSysCacheHashValue1(FOREIGNSERVEROID,
 																								 ObjectIdGetDatum(server->serverid));
-	conn->mapping_hashvalue = GetSysCacheHashValue1(USERMAPPINGOID, ObjectIdGetDatum(user->umid));
+	list_free(conn->mapping_hashvalues);
+	conn->mapping_hashvalues = NIL;
 	conn->invalidated = false;
 	conn->begin_remote_xact = false;
+	conn->xact_writes = false;
+	conn->xact_isolation_set = false;
+	conn->savepoint_level = 0;
+	conn->subxact_failed = false;
 	conn->keep_connections = true;
 	conn->stmt_ts = 0;
+	conn->tsn_reuse_interval = 0;
+	conn->stmt_cache_size = DEFAULT_STMT_CACHE_SIZE;
+	conn->idle_timeout = 0;
+	conn->max_lifetime = 0;
+	conn->max_concurrent_queries = 0;
+	conn->queue_timeout = DEFAULT_QUEUE_TIMEOUT;
+	conn->circuit_failures = 0;
+	conn->circuit_cooldown = DEFAULT_CIRCUIT_COOLDOWN;
+	conn->host_policy = TB_HOST_FAILOVER;
 
 	foreach(lc, server->options) {
 		DefElem *def = (DefElem *) lfirst(lc);
@@ -237,23 +1611,51 @@ make_tb_connection(ConnCacheEntry *conn, UserMapping *user)
 			host = defGetString(def);
 		} else if (strcmp(def->defname, "port") == 0) {
 			port = defGetString(def);
+		} else if (strcmp(def->defname, "hosts") == 0) {
+			hosts = defGetString(def);
+		} else if (strcmp(def->defname, "standby_hosts") == 0) {
+			standby_hosts = defGetString(def);
+		} else if (strcmp(def->defname, "host_policy") == 0) {
+			char *policy = defGetString(def);
+			if (strcmp(policy, "round_robin") == 0)
+				conn->host_policy = TB_HOST_ROUND_ROBIN;
+			else if (strcmp(policy, "least_connections") == 0)
+				conn->host_policy = TB_HOST_LEAST_CONNECTIONS;
 		} else if (strcmp(def->defname, "dbname") == 0) {
-			dbname = defGetString(def);
+			login->dbname = defGetString(def);
 		} else if (strcmp(def->defname, "keep_connections") == 0) {
 			conn->keep_connections = defGetBoolean(def);
+		} else if (strcmp(def->defname, "stmt_cache_size") == 0) {
+			(void) parse_int(defGetString(def), &conn->stmt_cache_size, 0, NULL);
+		} else if (strcmp(def->defname, "tsn_reuse_interval") == 0) {
+			(void) parse_int(defGetString(def), &conn->tsn_reuse_interval, 0, NULL);
+		} else if (strcmp(def->defname, "connect_timeout") == 0) {
+			(void) parse_int(defGetString(def), &login->connect_timeout, 0, NULL);
+		} else if (strcmp(def->defname, "idle_timeout") == 0) {
+			(void) parse_int(defGetString(def), &conn->idle_timeout, 0, NULL);
+		} else if (strcmp(def->defname, "max_lifetime") == 0) {
+			(void) parse_int(defGetString(def), &conn->max_lifetime, 0, NULL);
+		} else if (strcmp(def->defname, "max_concurrent_queries") == 0) {
+			(void) parse_int(defGetString(def), &conn->max_concurrent_queries, 0, NULL);
+		} else if (strcmp(def->defname, "queue_timeout") == 0) {
+			(void) parse_int(defGetString(def), &conn->queue_timeout, 0, NULL);
+		} else if (strcmp(def->defname, "circuit_failures") == 0) {
+			(void) parse_int(defGetString(def), &conn->circuit_failures, 0, NULL);
+		} else if (strcmp(def->defname, "circuit_cooldown") == 0) {
+			(void) parse_int(defGetString(def), &conn->circuit_cooldown, 0, NULL);
 		}
 	}
 
 	foreach(lc, user->options) {
 		DefElem *def = (DefElem *) lfirst(lc);
 		if (strcmp(def->defname, "username") == 0) {
-			username = defGetString(def);
+			login->username = defGetString(def);
 		} else if (strcmp(def->defname, "password") == 0) {
-			password = defGetString(def);
+			login->password = defGetString(def);
 		}
 	}
 
-	connect_tb_server(conn, host, port, dbname, username, password);
+	set_tb_endpoints(conn, host, port, hosts, standby_hosts);
 }
 
 static void
@@ -261,64 +1663,198 @@ TbfdwXactCallback(XactEvent event, void *arg)
 {
 	HASH_SEQ_STATUS scan;
 	ConnCacheEntry *conn;
-
-	if (!xact_got_connection)
+	ConnCacheEntry **ending;
+	int num_ending = 0;
+	bool commit = (event == XACT_EVENT_PRE_COMMIT || event == XACT_EVENT_PARALLEL_PRE_COMMIT);
+	bool abort = (event == XACT_EVENT_ABORT || event == XACT_EVENT_PARALLEL_ABORT);
+	int i;
+
+	/* Query slots left by statements the transaction did not release are given back at its end */
+	if (event == XACT_EVENT_COMMIT || event == XACT_EVENT_PARALLEL_COMMIT ||
+			event == XACT_EVENT_ABORT || event == XACT_EVENT_PARALLEL_ABORT)
+		release_tb_query_slots();
+
+	if (!xact_got_connection) {
+		close_expired_tb_connections(event);
 		return;
+	}
 
 	set_sleep_on_sig_on();
 
+	ending = (ConnCacheEntry **) palloc(sizeof(ConnCacheEntry *) *
+																			 Max(hash_get_num_entries(ConnectionHash), 1));
+
 	hash_seq_init(&scan, ConnectionHash);
 	while ((conn = (ConnCacheEntry *) hash_seq_search(&scan))) {
-		if (conn->begin_remote_xact) {
-			switch (event) {
-				case XACT_EVENT_PARALLEL_PRE_COMMIT:
-				case XACT_EVENT_PRE_COMMIT:
-					if (conn->connected) {
-						TbSQLEndTran(conn, SQL_COMMIT);
-						if (conn->invalidated || !conn->keep_connections) {
-							disconnect_tb_server(conn);
-						}
-					} break;
-				case XACT_EVENT_PRE_PREPARE:
-					break;
-				case XACT_EVENT_PARALLEL_COMMIT:
-				case XACT_EVENT_COMMIT:
-				case XACT_EVENT_PREPARE:
-					break;
-				case XACT_EVENT_PARALLEL_ABORT:
-				case XACT_EVENT_ABORT:
-					if (in_error_recursion_trouble()) {
-						conn->connected = false;
-						break;
-					}
-					if (conn->connected) {
-						TbSQLEndTran(conn, SQL_ROLLBACK);
-						if (conn->invalidated || !conn->keep_connections) {
-							disconnect_tb_server(conn);
-						}
-					} break;
-			}
+		/* Portals are closed by now, so a handle still in use was left by an aborted scan */
+		if (conn->connected && !in_error_recursion_trouble() && (commit || abort))
+			release_stmt_cache_in_use(conn);
+
+		if (!conn->begin_remote_xact)
+			continue;
+
+		if (commit && conn->subxact_failed && conn->connected)
+			ereport(ERROR,
+							(errcode(ERRCODE_FDW_ERROR),
+							 errmsg("could not roll back a subtransaction on server \"%s\"", conn->servername),
+							 errdetail("Writes of the subtransaction may remain on the server, so the "
+												 "transaction is rolled back.")));
+
+		if (abort && in_error_recursion_trouble()) {
+			conn->connected = false;
+			continue;
 		}
+
+		/* Remote transactions are ended together at pre-commit or abort */
+		if ((commit || abort) && conn->connected)
+			ending[num_ending++] = conn;
+	}
+
+	if (num_ending > 0)
+		end_remote_xacts(ending, num_ending, commit ? SQL_COMMIT : SQL_ROLLBACK);
+
+	for (i = 0; i < num_ending; i++) {
+		conn = ending[i];
+		if (conn->connected && (conn->invalidated || !conn->keep_connections))
+			disconnect_tb_server(conn);
+		else
+			conn->last_used = GetCurrentTimestamp();
 	}
+
+	pfree(ending);
 	xact_got_connection = false;
 
+	close_expired_tb_connections(event);
+
 	set_sleep_on_sig_off();
 }
 
+/*
+ * Drops kept connections that were idle for longer than idle_timeout or were made longer than
+ * max_lifetime ago, once the transaction has ended. The check is made at the end of every local
+ * transaction, so a backend that goes on without reading from Tibero gives its sessions back too.
+ * A kept connection whose server has all its allowed sessions open is dropped as well, so that the
+ * sessions follow the backends actually using the server rather than those that once did.
+ */
+static void
+close_expired_tb_connections(XactEvent event)
+{
+	HASH_SEQ_STATUS scan;
+	ConnCacheEntry *conn;
+	TimestampTz now;
+
+	if (ConnectionHash == NULL ||
+			(event != XACT_EVENT_COMMIT && event != XACT_EVENT_PARALLEL_COMMIT &&
+			 event != XACT_EVENT_ABORT && event != XACT_EVENT_PARALLEL_ABORT))
+		return;
+
+	now = GetCurrentTimestamp();
+
+	hash_seq_init(&scan, ConnectionHash);
+	while ((conn = (ConnCacheEntry *) hash_seq_search(&scan))) {
+		if (!conn->connected || conn->begin_remote_xact)
+			continue;
+
+		if ((conn->max_lifetime > 0 &&
+				 TimestampDifferenceExceeds(conn->connected_at, now, conn->max_lifetime * 1000)) ||
+				(conn->idle_timeout > 0 &&
+				 TimestampDifferenceExceeds(conn->last_used, now, conn->idle_timeout * 1000)) ||
+				(conn->session_counted && tb_session_limit_reached(conn->serverid))) {
+			/* The transaction is over, so no error may be raised for the disconnect */
+			abandon_tb_connection(conn);
+		}
+	}
+}
+
+/*
+ * Ends the savepoints of the subtransaction on Tibero. A rolled-back subtransaction rolls back the
+ * writes made on Tibero since its savepoint. Tibero has no RELEASE SAVEPOINT, so the savepoint of a
+ * committed one is left to its parent and set again by the next subtransaction at the same level.
+ */
 static void
 TbfdwSubxactCallback(SubXactEvent event, SubTransactionId mySubid, SubTransactionId parentSubid,
 										 void *arg)
 {
+	HASH_SEQ_STATUS scan;
+	ConnCacheEntry *conn;
+	int curlevel;
+
 	if (!xact_got_connection)
 		return;
 
+	if (event != SUBXACT_EVENT_PRE_COMMIT_SUB && event != SUBXACT_EVENT_ABORT_SUB)
+		return;
+
 	set_sleep_on_sig_on();
 
-	/* TODO */
+	curlevel = GetCurrentTransactionNestLevel();
+
+	hash_seq_init(&scan, ConnectionHash);
+	while ((conn = (ConnCacheEntry *) hash_seq_search(&scan))) {
+		if (!conn->connected || conn->savepoint_level < curlevel)
+			continue;
+
+		/* No error may be raised while aborting, the commit of the transaction reports it instead */
+		if (event == SUBXACT_EVENT_ABORT_SUB && !rollback_to_tb_savepoint(conn, curlevel))
+			conn->subxact_failed = true;
+
+		conn->savepoint_level = curlevel - 1;
+	}
 
 	set_sleep_on_sig_off();
 }
 
+static bool
+rollback_to_tb_savepoint(ConnCacheEntry *conn, int level)
+{
+	SQLHANDLE hstmt = SQL_NULL_HANDLE;
+	char sql[64];
+	SQLRETURN rc;
+
+	snprintf(sql, sizeof(sql), "ROLLBACK TO SAVEPOINT tbfdw_s%d", level);
+
+	/* Don't invoke tbcli wrapper function */
+	if (!SQL_SUCCEEDED(SQLAllocHandle(SQL_HANDLE_STMT, conn->hdbc, &hstmt)))
+		return false;
+	rc = SQLExecDirect(hstmt, (SQLCHAR *) sql, SQL_NTS);
+	SQLFreeHandle(SQL_HANDLE_STMT, hstmt);
+
+	return SQL_SUCCEEDED(rc);
+}
+
+/*
+ * Notes that the remote transaction of the connection writes. Each local subtransaction level the
+ * write is made in gets a savepoint on Tibero first, so that rolling the subtransaction back rolls
+ * back its remote writes too.
+ */
+void
+mark_tb_xact_writes(ConnCacheEntry *conn)
+{
+	int curlevel = GetCurrentTransactionNestLevel();
+	TbStatement tbStmt;
+	int level;
+
+	conn->xact_writes = true;
+
+	if (curlevel < 2 || conn->savepoint_level >= curlevel)
+		return;
+
+	memset(&tbStmt, 0, sizeof(tbStmt));
+	tbStmt.conn = conn;
+	TbSQLAllocHandle(conn, SQL_HANDLE_STMT, conn->hdbc, &tbStmt.hstmt);
+	track_tb_statement(&tbStmt);
+
+	for (level = Max(conn->savepoint_level + 1, 2); level <= curlevel; level++) {
+		char sql[64];
+
+		snprintf(sql, sizeof(sql), "SAVEPOINT tbfdw_s%d", level);
+		TbSQLExecDirect(&tbStmt, (SQLCHAR *) sql, SQL_NTS);
+		conn->savepoint_level = level;
+	}
+
+	release_tb_statement(&tbStmt);
+}
+
 static void
 TbfdwInvalCallback(Datum arg, int cacheid, uint32 hashvalue)
 {
@@ -337,7 +1873,7 @@ TbfdwInvalCallback(Datum arg, int cacheid, uint32 hashvalue)
 
 		if (hashvalue == 0 ||
 				(cacheid == FOREIGNSERVEROID && conn->server_hashvalue == hashvalue) ||
-				(cacheid == USERMAPPINGOID && conn->mapping_hashvalue == hashvalue)) {
+				(cacheid == USERMAPPINGOID && list_member_int(conn->mapping_hashvalues, (int) hashvalue))) {
 				conn->invalidated = true;
 		}
 	}
@@ -348,13 +1884,21 @@ TbfdwInvalCallback(Datum arg, int cacheid, uint32 hashvalue)
 void
 TbSQLFetch(TbStatement *tbStmt, int *cur_tuple_idx, bool *end_of_fetch)
 {
-	SQLRETURN rc = SQLFetch(tbStmt->hstmt);
+	SQLRETURN rc;
+
+	watch_tb_statement(tbStmt->hstmt);
+	rc = SQLFetch(tbStmt->hstmt);
+	unwatch_tb_statement();
+
 	if (rc == SQL_NO_DATA) {
 		if (end_of_fetch != NULL) *end_of_fetch = true;
 	} else if (rc == SQL_SUCCESS || rc == SQL_SUCCESS_WITH_INFO) {
 		/* TODO Add processing for SQL_SUCCESS_WITH_INFO */
 	} else {
-		TbFdwReportError(ERROR, ERRCODE_FDW_ERROR, psprintf("return code (%d)", rc), tbStmt->conn);
+		/* A statement cancelled by the watchdog reports the interrupt instead */
+		CHECK_FOR_INTERRUPTS();
+		TbFdwReportError(ERROR, ERRCODE_FDW_ERROR, psprintf("return code (%d)", rc), tbStmt->conn,
+										 SQL_HANDLE_STMT, tbStmt->hstmt);
 	}
 
 	if (cur_tuple_idx != NULL) *cur_tuple_idx = 0;
@@ -371,7 +1915,8 @@ TbSQLBindCol(TbStatement *tbStmt, SQLUSMALLINT col_no, SQLSMALLINT target_type,
 	if (rc == SQL_SUCCESS || rc == SQL_SUCCESS_WITH_INFO) {
 		/* TODO Add processing for SQL_SUCCESS_WITH_INFO */
 	} else {
-		TbFdwReportError(ERROR, ERRCODE_FDW_ERROR, psprintf("return code (%d)", rc), tbStmt->conn);
+		TbFdwReportError(ERROR, ERRCODE_FDW_ERROR, psprintf("return code (%d)", rc), tbStmt->conn,
+										 SQL_HANDLE_STMT, tbStmt->hstmt);
 	}
 }
 
@@ -382,9 +1927,11 @@ TbSQLEndTran(ConnCacheEntry *conn, SQLSMALLINT completion_type)
 	if (rc == SQL_SUCCESS || rc == SQL_SUCCESS_WITH_INFO) {
 		/* TODO Add processing for SQL_SUCCESS_WITH_INFO */
 	} else {
-		TbFdwReportError(ERROR, ERRCODE_FDW_ERROR, psprintf("return code (%d)", rc), conn);
+		TbFdwReportError(ERROR, ERRCODE_FDW_ERROR, psprintf("return code (%d)", rc), conn,
+										 SQL_HANDLE_DBC, conn->hdbc);
 	}
 	conn->begin_remote_xact = false;
+	conn->savepoint_level = 0;
 }
 
 void
@@ -394,18 +1941,26 @@ TbSQLSetStmtAttr(TbStatement *tbStmt, SQLINTEGER attribute, SQLPOINTER value, SQ
 	if (rc == SQL_SUCCESS || rc == SQL_SUCCESS_WITH_INFO) {
 		/* TODO Add processing for SQL_SUCCESS_WITH_INFO */
 	} else {
-		TbFdwReportError(ERROR, ERRCODE_FDW_ERROR, psprintf("return code (%d)", rc), tbStmt->conn);
+		TbFdwReportError(ERROR, ERRCODE_FDW_ERROR, psprintf("return code (%d)", rc), tbStmt->conn,
+										 SQL_HANDLE_STMT, tbStmt->hstmt);
 	}
 }
 
 void
 TbSQLExecDirect(TbStatement *tbStmt, SQLCHAR *sql, SQLINTEGER sql_len)
 {
-	SQLRETURN rc = SQLExecDirect(tbStmt->hstmt, sql, sql_len);
+	SQLRETURN rc;
+
+	watch_tb_statement(tbStmt->hstmt);
+	rc = SQLExecDirect(tbStmt->hstmt, sql, sql_len);
+	unwatch_tb_statement();
+
 	if (rc == SQL_SUCCESS || rc == SQL_SUCCESS_WITH_INFO) {
 		/* TODO Add processing for SQL_SUCCESS_WITH_INFO */
 	} else {
-		TbFdwReportError(ERROR, ERRCODE_FDW_ERROR, psprintf("return code (%d)", rc), tbStmt->conn);
+		CHECK_FOR_INTERRUPTS();
+		TbFdwReportError(ERROR, ERRCODE_FDW_ERROR, psprintf("return code (%d)", rc), tbStmt->conn,
+										 SQL_HANDLE_STMT, tbStmt->hstmt);
 	}
 }
 
@@ -417,7 +1972,10 @@ TbSQLAllocHandle(ConnCacheEntry *conn, SQLSMALLINT handle_type, SQLHANDLE input_
 	if (rc == SQL_SUCCESS || rc == SQL_SUCCESS_WITH_INFO) {
 		/* TODO Add processing for SQL_SUCCESS_WITH_INFO */
 	} else {
-		TbFdwReportError(ERROR, ERRCODE_FDW_ERROR, psprintf("return code (%d)", rc), conn);
+		/* Diagnostics of a failed allocation are kept on the parent handle */
+		TbFdwReportError(ERROR, ERRCODE_FDW_ERROR, psprintf("return code (%d)", rc), conn,
+										 handle_type == SQL_HANDLE_STMT ? SQL_HANDLE_DBC : SQL_HANDLE_ENV,
+										 input_handle);
 	}
 }
 
@@ -428,19 +1986,27 @@ TbSQLFreeStmt(TbStatement *tbStmt, SQLUSMALLINT option)
 	if (rc == SQL_SUCCESS || rc == SQL_SUCCESS_WITH_INFO) {
 		/* TODO Add processing for SQL_SUCCESS_WITH_INFO */
 	} else {
-		TbFdwReportError(ERROR, ERRCODE_FDW_ERROR, psprintf("return code (%d)", rc), tbStmt->conn);
+		TbFdwReportError(ERROR, ERRCODE_FDW_ERROR, psprintf("return code (%d)", rc), tbStmt->conn,
+										 SQL_HANDLE_STMT, tbStmt->hstmt);
 	}
 }
 
 void
 TbSQLExecute(TbStatement *tbStmt)
 {
-	SQLRETURN rc = SQLExecute(tbStmt->hstmt);
+	SQLRETURN rc;
+
+	watch_tb_statement(tbStmt->hstmt);
+	rc = SQLExecute(tbStmt->hstmt);
+	unwatch_tb_statement();
+
 	if (rc == SQL_SUCCESS || rc == SQL_SUCCESS_WITH_INFO) {
 		/* TODO Add processing for SQL_SUCCESS_WITH_INFO */
 		tbStmt->query_executed = true;
 	} else {
-		TbFdwReportError(ERROR, ERRCODE_FDW_ERROR, psprintf("return code (%d)", rc), tbStmt->conn);
+		CHECK_FOR_INTERRUPTS();
+		TbFdwReportError(ERROR, ERRCODE_FDW_ERROR, psprintf("return code (%d)", rc), tbStmt->conn,
+										 SQL_HANDLE_STMT, tbStmt->hstmt);
 	}
 }
 
@@ -456,7 +2022,8 @@ TbSQLBindParameter(TbStatement *tbStmt, SQLUSMALLINT param_no, SQLSMALLINT input
 	if (rc == SQL_SUCCESS || rc == SQL_SUCCESS_WITH_INFO) {
 		/* TODO Add processing for SQL_SUCCESS_WITH_INFO */
 	} else {
-		TbFdwReportError(ERROR, ERRCODE_FDW_ERROR, psprintf("return code (%d)", rc), tbStmt->conn);
+		TbFdwReportError(ERROR, ERRCODE_FDW_ERROR, psprintf("return code (%d)", rc), tbStmt->conn,
+										 SQL_HANDLE_STMT, tbStmt->hstmt);
 	}
 }
 
@@ -471,7 +2038,8 @@ TbSQLDescribeCol(TbStatement *tbStmt, SQLUSMALLINT col_no, SQLCHAR *col_name,
 		/* TODO Add processing for SQL_SUCCESS_WITH_INFO */
 		*col_size = get_tb_type_max_str_size(*data_type, *col_size, tbStmt->conn);
 	} else {
-		TbFdwReportError(ERROR, ERRCODE_FDW_ERROR, psprintf("return code (%d)", rc), tbStmt->conn);
+		TbFdwReportError(ERROR, ERRCODE_FDW_ERROR, psprintf("return code (%d)", rc), tbStmt->conn,
+										 SQL_HANDLE_STMT, tbStmt->hstmt);
 	}
 }
 
@@ -482,7 +2050,8 @@ TbSQLPrepare(TbStatement *tbStmt, SQLCHAR *sql, SQLINTEGER sql_len)
 	if (rc == SQL_SUCCESS || rc == SQL_SUCCESS_WITH_INFO) {
 		/* TODO Add processing for SQL_SUCCESS_WITH_INFO */
 	} else {
-		TbFdwReportError(ERROR, ERRCODE_FDW_ERROR, psprintf("return code (%d)", rc), tbStmt->conn);
+		TbFdwReportError(ERROR, ERRCODE_FDW_ERROR, psprintf("return code (%d)", rc), tbStmt->conn,
+										 SQL_HANDLE_STMT, tbStmt->hstmt);
 	}
 }
 
@@ -497,7 +2066,8 @@ TbSQLDriverConnect(ConnCacheEntry *conn, SQLHWND window_handle, SQLCHAR *in_conn
 		/* TODO Add processing for SQL_SUCCESS_WITH_INFO */
 	} else {
 		TbFdwReportError(ERROR, ERRCODE_FDW_UNABLE_TO_ESTABLISH_CONNECTION,
-										 psprintf("return code (%d)", rc), conn);
+										 psprintf("return code (%d)", rc), conn,
+										 SQL_HANDLE_DBC, conn->hdbc);
 	}
 }
 
@@ -508,7 +2078,8 @@ TbSQLDisconnect(ConnCacheEntry *conn)
 	if (rc == SQL_SUCCESS || rc == SQL_SUCCESS_WITH_INFO) {
 		/* TODO Add processing for SQL_SUCCESS_WITH_INFO */
 	} else {
-		TbFdwReportError(ERROR, ERRCODE_FDW_ERROR, psprintf("return code (%d)", rc), conn);
+		TbFdwReportError(ERROR, ERRCODE_FDW_ERROR, psprintf("return code (%d)", rc), conn,
+										 SQL_HANDLE_DBC, conn->hdbc);
 	}
 }
 
@@ -519,7 +2090,8 @@ TbSQLFreeHandle(ConnCacheEntry *conn, SQLSMALLINT handle_type, SQLHANDLE handle)
 	if (rc == SQL_SUCCESS || rc == SQL_SUCCESS_WITH_INFO) {
 		/* TODO Add processing for SQL_SUCCESS_WITH_INFO */
 	} else {
-		TbFdwReportError(ERROR, ERRCODE_FDW_ERROR, psprintf("return code (%d)", rc), conn);
+		TbFdwReportError(ERROR, ERRCODE_FDW_ERROR, psprintf("return code (%d)", rc), conn,
+										 handle_type, handle);
 	}
 }
 
@@ -531,7 +2103,8 @@ TbSQLSetConnectAttr(ConnCacheEntry *conn, SQLINTEGER attribute, SQLPOINTER value
 	if (rc == SQL_SUCCESS || rc == SQL_SUCCESS_WITH_INFO) {
 		/* TODO Add processing for SQL_SUCCESS_WITH_INFO */
 	} else {
-		TbFdwReportError(ERROR, ERRCODE_FDW_ERROR, psprintf("return code (%d)", rc), conn);
+		TbFdwReportError(ERROR, ERRCODE_FDW_ERROR, psprintf("return code (%d)", rc), conn,
+										 SQL_HANDLE_DBC, conn->hdbc);
 	}
 }
 
@@ -542,7 +2115,8 @@ TbSQLSetEnvAttr(ConnCacheEntry *conn, SQLINTEGER attribute, SQLPOINTER value, SQ
 	if (rc == SQL_SUCCESS || rc == SQL_SUCCESS_WITH_INFO) {
 		/* TODO Add processing for SQL_SUCCESS_WITH_INFO */
 	} else {
-		TbFdwReportError(ERROR, ERRCODE_FDW_ERROR, psprintf("return code (%d)", rc), conn);
+		TbFdwReportError(ERROR, ERRCODE_FDW_ERROR, psprintf("return code (%d)", rc), conn,
+										 SQL_HANDLE_ENV, conn->henv);
 	}
 }
 
@@ -553,7 +2127,65 @@ TbSQLNumResultCols(TbStatement *tbStmt, SQLSMALLINT *col_cnt)
 	if (rc == SQL_SUCCESS || rc == SQL_SUCCESS_WITH_INFO) {
 		/* TODO Add processing for SQL_SUCCESS_WITH_INFO */
 	} else {
-		TbFdwReportError(ERROR, ERRCODE_FDW_ERROR, psprintf("return code (%d)", rc), tbStmt->conn);
+		TbFdwReportError(ERROR, ERRCODE_FDW_ERROR, psprintf("return code (%d)", rc), tbStmt->conn,
+										 SQL_HANDLE_STMT, tbStmt->hstmt);
+	}
+}
+
+void
+TbSQLCancel(TbStatement *tbStmt)
+{
+	SQLRETURN rc = SQLCancel(tbStmt->hstmt);
+	if (rc == SQL_SUCCESS || rc == SQL_SUCCESS_WITH_INFO) {
+		/* TODO Add processing for SQL_SUCCESS_WITH_INFO */
+	} else {
+		TbFdwReportError(ERROR, ERRCODE_FDW_ERROR, psprintf("return code (%d)", rc), tbStmt->conn,
+										 SQL_HANDLE_STMT, tbStmt->hstmt);
+	}
+}
+
+void
+TbSQLRowCount(TbStatement *tbStmt, SQLINTEGER *row_cnt)
+{
+	SQLRETURN rc = SQLRowCount(tbStmt->hstmt, row_cnt);
+	if (rc == SQL_SUCCESS || rc == SQL_SUCCESS_WITH_INFO) {
+		/* TODO Add processing for SQL_SUCCESS_WITH_INFO */
+	} else {
+		TbFdwReportError(ERROR, ERRCODE_FDW_ERROR, psprintf("return code (%d)", rc), tbStmt->conn,
+										 SQL_HANDLE_STMT, tbStmt->hstmt);
+	}
+}
+
+void
+TbSQLSetPos(TbStatement *tbStmt, SQLUSMALLINT row_number, SQLUSMALLINT operation,
+						SQLUSMALLINT lock_type)
+{
+	SQLRETURN rc = SQLSetPos(tbStmt->hstmt, row_number, operation, lock_type);
+	if (rc == SQL_SUCCESS || rc == SQL_SUCCESS_WITH_INFO) {
+		/* TODO Add processing for SQL_SUCCESS_WITH_INFO */
+	} else {
+		TbFdwReportError(ERROR, ERRCODE_FDW_ERROR, psprintf("return code (%d)", rc), tbStmt->conn,
+										 SQL_HANDLE_STMT, tbStmt->hstmt);
+	}
+}
+
+void
+TbSQLGetData(TbStatement *tbStmt, SQLUSMALLINT col_no, SQLSMALLINT target_type,
+						 SQLPOINTER target_value, SQLLEN buffer_len, SQLLEN *str_len_or_ind)
+{
+	SQLRETURN rc;
+
+	watch_tb_statement(tbStmt->hstmt);
+	rc = SQLGetData(tbStmt->hstmt, col_no, target_type, target_value, buffer_len, str_len_or_ind);
+	unwatch_tb_statement();
+
+	if (rc == SQL_SUCCESS || rc == SQL_SUCCESS_WITH_INFO) {
+		/* TODO Add processing for SQL_SUCCESS_WITH_INFO */
+	} else {
+		/* A statement cancelled by the watchdog reports the interrupt instead */
+		CHECK_FOR_INTERRUPTS();
+		TbFdwReportError(ERROR, ERRCODE_FDW_ERROR, psprintf("return code (%d)", rc), tbStmt->conn,
+										 SQL_HANDLE_STMT, tbStmt->hstmt);
 	}
 }
 
@@ -627,7 +2259,8 @@ get_tb_type_max_str_size(int type, SQLUINTEGER col_size, ConnCacheEntry *conn)
 			break;
 
 		default:
-			TbFdwReportError(ERROR, ERRCODE_FDW_ERROR, psprintf("tbcli datatype error (%d)", type), conn);
+			TbFdwReportError(ERROR, ERRCODE_FDW_ERROR, psprintf("tbcli datatype error (%d)", type), conn,
+										 0, SQL_NULL_HANDLE);
 			break;
 	}
 
@@ -645,7 +2278,7 @@ get_tb_type_from_pg_type(Oid type)
 		case INT4OID:
 			return SQL_INTEGER;
 		case INT8OID:
-			return SQL_INTEGER;
+			return SQL_BIGINT;
 		case FLOAT4OID:
 			return SQL_FLOAT;
 		case FLOAT8OID:
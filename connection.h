@@ -13,32 +13,155 @@
 #ifndef TIBERO_FDW_CONNECTION_H
 #define TIBERO_FDW_CONNECTION_H
 
+#include "datatype/timestamp.h"
+#include "foreign/foreign.h"
+#include "lib/ilist.h"
 #include "sqlcli.h"
 #include "sqlcli_types.h"
+#include "tibero_fdw.h"
 
-typedef Oid ConnCacheKey;
+/* Length of the extended ROWID string */
+#define EROWID_SGMT_LEN 6
+#define EROWID_FILE_LEN 3
+#define EROWID_BLOCK_LEN 6
+#define EROWID_ROW_LEN 3
+#define EROWID_SIZE (EROWID_SGMT_LEN + EROWID_FILE_LEN + EROWID_BLOCK_LEN + EROWID_ROW_LEN)
+
+/*
+ * Connections are shared by the user mappings of a server that log in with the same credentials,
+ * such as a PUBLIC mapping and the mapping of a role naming the same Tibero user. The key holds a
+ * 64-bit hash of the user name and password, and logins whose credentials hash the same are told
+ * apart by the position in their chain, checked against the credentials kept in the entry.
+ */
+typedef struct ConnCacheKey
+{
+	Oid serverid;
+	uint32 collision;
+	uint64 credentials_hash;
+} ConnCacheKey;
+
+/*
+ * Statement handle prepared for a SQL text and kept open on its connection for reuse. A handle that
+ * is not cached is listed too, without SQL text, until it is released. An entry in use by a scan or
+ * modify is detached rather than freed when its connection is dropped, and is freed when released.
+ */
+typedef struct TbStmtCacheEntry
+{
+	dlist_node node;
+	char *sql;
+	SQLHANDLE hstmt;
+	bool in_use;
+	bool detached;
+} TbStmtCacheEntry;
+
+typedef enum TbHostPolicy
+{
+	TB_HOST_FAILOVER,
+	TB_HOST_ROUND_ROBIN,
+	TB_HOST_LEAST_CONNECTIONS
+} TbHostPolicy;
+
+/*
+ * Endpoint of a server, listed by its host and port options or by its hosts and standby_hosts
+ * options, with the health seen by the backend.
+ */
+typedef struct TbEndpoint
+{
+	char host[TB_ENDPOINT_HOST_LEN];
+	char port[TB_ENDPOINT_PORT_LEN];
+	bool standby;
+
+	/* Connections that failed in a row, and when the last one did */
+	int failures;
+	TimestampTz failed_at;
+} TbEndpoint;
+
+/* Error of a failed login, kept to be reported later */
+typedef struct TbConnectError
+{
+	SQLRETURN rc;
+	char sqlstate[6];
+	SQLINTEGER native_error;
+	char message[SQL_MAX_MESSAGE_LENGTH];
+} TbConnectError;
 
 typedef struct ConnCacheEntry
 {
 	ConnCacheKey key;
 
+	/* User name and password of the login, separated by a NUL */
+	char *credentials;
+	int credentials_len;
+
 	SQLHANDLE henv;
 	SQLHANDLE hdbc;
 
 	bool connected;
 
+	/* The session is counted against tibero_fdw.max_sessions_per_server */
+	bool session_counted;
+
 	bool begin_remote_xact;
 
+	/* The remote transaction wrote, or set its isolation level, and has to be ended */
+	bool xact_writes;
+	bool xact_isolation_set;
+
+	/*
+	 * Deepest local subtransaction level with a savepoint on Tibero, zero if none, and whether the
+	 * rollback of a subtransaction failed on Tibero, so that the transaction may not commit
+	 */
+	int savepoint_level;
+	bool subxact_failed;
+
 	bool invalidated;
 	bool keep_connections;
 
 	Oid serverid;
+	char servername[NAMEDATALEN];
 	uint32 server_hashvalue;
-	uint32 mapping_hashvalue;
+
+	/* Hash values of the user mappings that used the connection since it was made */
+	List *mapping_hashvalues;
 
 	char tsn[32];
 
+	/* Statement start the TSN was taken for, and how long it may be reused in milliseconds */
 	TimestampTz stmt_ts;
+	int tsn_reuse_interval;
+
+	/* When the connection was made and last ended a transaction, and the limits in seconds on both */
+	TimestampTz connected_at;
+	TimestampTz last_used;
+	int max_lifetime;
+	int idle_timeout;
+
+	/* Backends allowed to run queries on the server at once, and how long to wait in milliseconds */
+	int max_concurrent_queries;
+	int queue_timeout;
+
+	/* Connections failing in a row that stop further ones, and for how many seconds */
+	int circuit_failures;
+	int circuit_cooldown;
+
+	/* Endpoints of the server, how one is picked, and the one connected to */
+	TbEndpoint endpoints[TB_FDW_MAX_ENDPOINTS];
+	int num_endpoints;
+	TbHostPolicy host_policy;
+	int endpoint;
+	bool endpoint_counted;
+
+	/*
+	 * Error of the last login that failed. One that failed in connect_tb_servers is reported by the
+	 * scans of the statement it was made for.
+	 */
+	TimestampTz connect_failed_stmt_ts;
+	TbConnectError connect_error;
+
+	/* Prepared statements of the connection, most recently used first */
+	dlist_head stmt_cache;
+	int stmt_cache_cnt;
+	int stmt_cache_size;
 
 } ConnCacheEntry;
 
@@ -49,6 +172,8 @@ typedef struct TbStatement
 	ConnCacheEntry *conn;
 	SQLSMALLINT res_col_cnt;
 	bool query_executed;
+	TbStmtCacheEntry *cache_entry;
+	bool query_slot_held;
 } TbStatement;
 
 /* {{{ tbcli wrapper ******************************************************************************/
@@ -81,8 +206,21 @@ void TbSQLSetConnectAttr(ConnCacheEntry *entry, SQLINTEGER attribute, SQLPOINTER
 void TbSQLSetEnvAttr(ConnCacheEntry *entry, SQLINTEGER attribute, SQLPOINTER value,
  							 			 SQLINTEGER str_len);
 void TbSQLNumResultCols(TbStatement *tbStmt, SQLSMALLINT *col_cnt);
+void TbSQLCancel(TbStatement *tbStmt);
+void TbSQLRowCount(TbStatement *tbStmt, SQLINTEGER *row_cnt);
+void TbSQLSetPos(TbStatement *tbStmt, SQLUSMALLINT row_number, SQLUSMALLINT operation,
+								 SQLUSMALLINT lock_type);
+void TbSQLGetData(TbStatement *tbStmt, SQLUSMALLINT col_no, SQLSMALLINT target_type,
+									SQLPOINTER target_value, SQLLEN buffer_len, SQLLEN *str_len_or_ind);
 /****************************************************************************** tbcli wrapper }}} */
 
 void get_tb_statement(UserMapping *user, TbStatement *tbStmt, bool use_fb_query);
+void get_tb_prepared_statement(UserMapping *user, TbStatement *tbStmt, bool use_fb_query,
+															 char *sql);
+void release_tb_statement(TbStatement *tbStmt);
+void mark_tb_xact_writes(ConnCacheEntry *conn);
+void connect_tb_servers(List *users);
+void prefetch_tb_snapshots(List *users);
+void preconnect_tb_servers(const char *servers);
 
 #endif							/* TIBERO_FDW_CONNECTION_H */
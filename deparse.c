@@ -223,9 +223,7 @@ deparse_target_list(StringInfo buf, RangeTblEntry *rte, Index rtindex, Relation
 			appendStringInfoString(buf, " RETURNING ");
 		first = false;
 
-		if (qualify_col)
-			ADD_REL_QUALIFIER(buf, rtindex);
-		appendStringInfoString(buf, "ctid");
+		deparse_column_ref(buf, rtindex, SelfItemPointerAttributeNumber, rte, qualify_col);
 
 		*retrieved_attrs = lappend_int(*retrieved_attrs, SelfItemPointerAttributeNumber);
 	}
@@ -842,15 +840,16 @@ remote_sql_get_buffer(RemoteSQLInfo *remote_sql)
 }
 
 void
-deparse_insert_sql(StringInfo buf, PlannerInfo *root, Index rtindex, Relation rel,
-									 List *targetAttrs)
+deparse_insert_sql(StringInfo buf, RangeTblEntry *rte, Index rtindex, Relation rel,
+									 List *targetAttrs, bool bulk_load)
 {
 	ListCell *lc;
-	RangeTblEntry *rte;
-
-	rte = planner_rt_fetch(rtindex, root);
 
-	appendStringInfo(buf, "INSERT INTO ");
+	/* Direct-path insert writes above the high water mark, bypassing the buffer cache */
+	if (bulk_load)
+		appendStringInfo(buf, "INSERT /*+ APPEND */ INTO ");
+	else
+		appendStringInfo(buf, "INSERT INTO ");
 	deparse_relation(buf, rel, false);
 
 	if (targetAttrs) {
@@ -871,14 +870,351 @@ deparse_insert_sql(StringInfo buf, PlannerInfo *root, Index rtindex, Relation re
 
 		first = true;
 		foreach(lc, targetAttrs) {
+			int attnum = lfirst_int(lc);
+			Form_pg_attribute attr = TupleDescAttr(RelationGetDescr(rel), attnum - 1);
+
 			if (!first)
 				appendStringInfoString(buf, ", ");
 			first = false;
 
-			appendStringInfo(buf, "?");
+			if (attr->attgenerated)
+				appendStringInfoString(buf, "DEFAULT");
+			else
+				appendStringInfo(buf, "?");
 		}
 		appendStringInfoChar(buf, ')');
 	} else {
 		Assert(false);
 	}
 }
+
+/*
+ * Deparses INSERT INTO ... SELECT for a source scan shipped together with its target table. The
+ * select list holds the expressions computed for the target columns, and the source relation is
+ * read without the flashback clause so that the statement needs no parameters.
+ */
+void
+deparse_direct_insert_sql(StringInfo buf, PlannerInfo *root, Index rtindex, Relation rel,
+													RelOptInfo *foreignrel, List *targetAttrs, List *exprs,
+													List *remote_conds)
+{
+	RangeTblEntry *rte = planner_rt_fetch(rtindex, root);
+	DeparseContext context;
+	ListCell *lc;
+	bool first;
+
+	Assert(IS_SIMPLE_REL(foreignrel));
+	Assert(list_length(targetAttrs) == list_length(exprs));
+
+	context.root = root;
+	context.foreignrel = foreignrel;
+	context.scanrel = foreignrel;
+	context.remote_sql.buf = buf;
+	context.remote_sql.pdepth = 0;
+	context.params_list = NULL;
+	context.use_fb_query = false;
+
+	appendStringInfoString(buf, "INSERT INTO ");
+	deparse_relation(buf, rel, false);
+	appendStringInfoString(buf, " (");
+
+	first = true;
+	foreach(lc, targetAttrs)
+	{
+		if (!first)
+			appendStringInfoString(buf, ", ");
+		first = false;
+		deparse_column_ref(buf, rtindex, lfirst_int(lc), rte, false);
+	}
+
+	appendStringInfoString(buf, ") SELECT ");
+
+	first = true;
+	foreach(lc, exprs)
+	{
+		if (!first)
+			appendStringInfoString(buf, ", ");
+		first = false;
+		deparse_expr((Node *) lfirst(lc), &context);
+	}
+
+	deparse_from_expr(remote_conds, &context);
+
+	remote_sql_check_sanity(&context.remote_sql);
+}
+
+/*
+ * Deparses UPDATE of the target table run as a whole on the remote side: the changed columns are set
+ * to the given shippable expressions for the rows matching the remote conditions.
+ */
+void
+deparse_direct_update_sql(StringInfo buf, PlannerInfo *root, Index rtindex, Relation rel,
+													RelOptInfo *foreignrel, List *targetAttrs, List *exprs,
+													List *remote_conds)
+{
+	RangeTblEntry *rte = planner_rt_fetch(rtindex, root);
+	DeparseContext context;
+	ListCell *lc,
+					 *lc2;
+	bool first;
+
+	Assert(IS_SIMPLE_REL(foreignrel));
+	Assert(list_length(targetAttrs) == list_length(exprs));
+
+	context.root = root;
+	context.foreignrel = foreignrel;
+	context.scanrel = foreignrel;
+	context.remote_sql.buf = buf;
+	context.remote_sql.pdepth = 0;
+	context.params_list = NULL;
+	context.use_fb_query = false;
+
+	appendStringInfoString(buf, "UPDATE ");
+	deparse_relation(buf, rel, false);
+	appendStringInfoString(buf, " SET ");
+
+	first = true;
+	forboth(lc, targetAttrs, lc2, exprs)
+	{
+		if (!first)
+			appendStringInfoString(buf, ", ");
+		first = false;
+
+		deparse_column_ref(buf, rtindex, lfirst_int(lc), rte, false);
+		appendStringInfoString(buf, " = ");
+		deparse_expr((Node *) lfirst(lc2), &context);
+	}
+
+	if (remote_conds != NIL)
+		deparse_where_expr(remote_conds, &context);
+
+	remote_sql_check_sanity(&context.remote_sql);
+}
+
+/*
+ * Deparses DELETE of the rows of the target table matching the remote conditions, run as a whole on
+ * the remote side.
+ */
+void
+deparse_direct_delete_sql(StringInfo buf, PlannerInfo *root, Index rtindex, Relation rel,
+													RelOptInfo *foreignrel, List *remote_conds)
+{
+	DeparseContext context;
+
+	Assert(IS_SIMPLE_REL(foreignrel));
+
+	context.root = root;
+	context.foreignrel = foreignrel;
+	context.scanrel = foreignrel;
+	context.remote_sql.buf = buf;
+	context.remote_sql.pdepth = 0;
+	context.params_list = NULL;
+	context.use_fb_query = false;
+
+	appendStringInfoString(buf, "DELETE FROM ");
+	deparse_relation(buf, rel, false);
+
+	if (remote_conds != NIL)
+		deparse_where_expr(remote_conds, &context);
+
+	remote_sql_check_sanity(&context.remote_sql);
+}
+
+/*
+ * Deparses INSERT ... ON CONFLICT DO NOTHING as a MERGE which inserts the bound row only when no row
+ * with the same key exists. The row is bound through a single-row subquery on DUAL, so the statement
+ * takes the same parameters as the plain INSERT and can be executed with array binding.
+ */
+void
+deparse_merge_insert_sql(StringInfo buf, RangeTblEntry *rte, Index rtindex, Relation rel,
+												 List *targetAttrs, List *keyAttrs)
+{
+	ListCell *lc;
+	bool first;
+
+	Assert(targetAttrs != NIL && keyAttrs != NIL);
+
+	appendStringInfoString(buf, "MERGE INTO ");
+	deparse_relation(buf, rel, false);
+	appendStringInfo(buf, " %s%d USING (SELECT ", REL_ALIAS_PREFIX, rtindex);
+
+	first = true;
+	foreach(lc, targetAttrs)
+	{
+		int attnum = lfirst_int(lc);
+
+		if (TupleDescAttr(RelationGetDescr(rel), attnum - 1)->attgenerated)
+			continue;
+
+		if (!first)
+			appendStringInfoString(buf, ", ");
+		first = false;
+		appendStringInfo(buf, "? %s%d", SUBQUERY_COL_ALIAS_PREFIX, attnum);
+	}
+	appendStringInfo(buf, " FROM DUAL) %s%d ON (", SUBQUERY_REL_ALIAS_PREFIX, rtindex);
+
+	first = true;
+	foreach(lc, keyAttrs)
+	{
+		int attnum = lfirst_int(lc);
+
+		if (!first)
+			appendStringInfoString(buf, " AND ");
+		first = false;
+		deparse_column_ref(buf, rtindex, attnum, rte, true);
+		appendStringInfo(buf, " = %s%d.%s%d", SUBQUERY_REL_ALIAS_PREFIX, rtindex,
+										 SUBQUERY_COL_ALIAS_PREFIX, attnum);
+	}
+
+	appendStringInfoString(buf, ") WHEN NOT MATCHED THEN INSERT (");
+
+	first = true;
+	foreach(lc, targetAttrs)
+	{
+		if (!first)
+			appendStringInfoString(buf, ", ");
+		first = false;
+		deparse_column_ref(buf, rtindex, lfirst_int(lc), rte, false);
+	}
+
+	appendStringInfoString(buf, ") VALUES (");
+
+	first = true;
+	foreach(lc, targetAttrs)
+	{
+		int attnum = lfirst_int(lc);
+
+		if (!first)
+			appendStringInfoString(buf, ", ");
+		first = false;
+
+		if (TupleDescAttr(RelationGetDescr(rel), attnum - 1)->attgenerated)
+			appendStringInfoString(buf, "DEFAULT");
+		else
+			appendStringInfo(buf, "%s%d.%s%d", SUBQUERY_REL_ALIAS_PREFIX, rtindex,
+											 SUBQUERY_COL_ALIAS_PREFIX, attnum);
+	}
+	appendStringInfoChar(buf, ')');
+}
+
+/*
+ * Deparses UPDATE of the changed columns of the row located by its ROWID. The ROWID is bound as the
+ * last parameter, after the new column values.
+ */
+void
+deparse_update_sql(StringInfo buf, RangeTblEntry *rte, Index rtindex, Relation rel,
+									 List *targetAttrs)
+{
+	ListCell *lc;
+	bool first;
+
+	Assert(targetAttrs != NIL);
+
+	appendStringInfoString(buf, "UPDATE ");
+	deparse_relation(buf, rel, false);
+	appendStringInfoString(buf, " SET ");
+
+	first = true;
+	foreach(lc, targetAttrs)
+	{
+		int attnum = lfirst_int(lc);
+
+		if (!first)
+			appendStringInfoString(buf, ", ");
+		first = false;
+
+		deparse_column_ref(buf, rtindex, attnum, rte, false);
+		if (TupleDescAttr(RelationGetDescr(rel), attnum - 1)->attgenerated)
+			appendStringInfoString(buf, " = DEFAULT");
+		else
+			appendStringInfoString(buf, " = ?");
+	}
+	appendStringInfoString(buf, " WHERE ROWID = ?");
+}
+
+/*
+ * Deparses DELETE of the row located by its ROWID, which is bound as the only parameter.
+ */
+void
+deparse_delete_sql(StringInfo buf, Relation rel)
+{
+	appendStringInfoString(buf, "DELETE FROM ");
+	deparse_relation(buf, rel, false);
+	appendStringInfoString(buf, " WHERE ROWID = ?");
+}
+
+/*
+ * Deparses TRUNCATE of a single table, since Tibero truncates one table per statement.
+ */
+void
+deparse_truncate_sql(StringInfo buf, Relation rel)
+{
+	appendStringInfoString(buf, "TRUNCATE TABLE ");
+	deparse_relation(buf, rel, false);
+}
+
+/*
+ * Deparses the dictionary query of IMPORT FOREIGN SCHEMA. The remote schema is given as the caller
+ * folded it, since the generated tables name it as their owner.
+ */
+void
+deparse_import_schema_sql(StringInfo buf, ImportForeignSchemaStmt *stmt, const char *remote_schema)
+{
+	ListCell *lc;
+
+	/*
+	 * Columns of every table in the remote schema are read by one dictionary query. Rows are ordered
+	 * by table so that the caller can build a CREATE FOREIGN TABLE statement per table while fetching.
+	 */
+	appendStringInfoString(buf,
+												 "SELECT c.TABLE_NAME, c.COLUMN_NAME, c.DATA_TYPE, c.DATA_PRECISION, "
+												 "c.DATA_SCALE, c.CHAR_LENGTH, c.NULLABLE, "
+												 "CASE WHEN EXISTS (SELECT 1 FROM ALL_CONSTRAINTS k, ALL_CONS_COLUMNS kc "
+												 "WHERE k.OWNER = c.OWNER AND k.TABLE_NAME = c.TABLE_NAME "
+												 "AND k.CONSTRAINT_TYPE = 'P' AND kc.OWNER = k.OWNER "
+												 "AND kc.CONSTRAINT_NAME = k.CONSTRAINT_NAME "
+												 "AND kc.COLUMN_NAME = c.COLUMN_NAME) THEN 'Y' ELSE 'N' END "
+												 "FROM ALL_TAB_COLUMNS c "
+												 "WHERE c.OWNER = ");
+	deparse_string_literal(buf, remote_schema);
+	appendStringInfoString(buf, " AND c.TABLE_NAME NOT LIKE 'BIN$%'");
+
+	if (stmt->list_type == FDW_IMPORT_SCHEMA_LIMIT_TO ||
+			stmt->list_type == FDW_IMPORT_SCHEMA_EXCEPT)
+	{
+		bool first = true;
+
+		if (stmt->list_type == FDW_IMPORT_SCHEMA_EXCEPT)
+			appendStringInfoString(buf, " AND c.TABLE_NAME NOT IN (");
+		else
+			appendStringInfoString(buf, " AND c.TABLE_NAME IN (");
+
+		/*
+		 * Local table names are folded to lower case when the remote name is all upper case, so both
+		 * spellings of each listed name are sent to the remote server.
+		 */
+		foreach(lc, stmt->table_list)
+		{
+			RangeVar *rv = (RangeVar *) lfirst(lc);
+			char *upper_name = pstrdup(rv->relname);
+			char *ptr;
+
+			for (ptr = upper_name; *ptr; ptr++)
+				*ptr = pg_toupper((unsigned char) *ptr);
+
+			if (!first)
+				appendStringInfoString(buf, ", ");
+			first = false;
+
+			deparse_string_literal(buf, rv->relname);
+			if (strcmp(upper_name, rv->relname) != 0)
+			{
+				appendStringInfoString(buf, ", ");
+				deparse_string_literal(buf, upper_name);
+			}
+		}
+		appendStringInfoChar(buf, ')');
+	}
+
+	appendStringInfoString(buf, " ORDER BY c.TABLE_NAME, c.COLUMN_ID");
+}
@@ -23,6 +23,7 @@
 #include "nodes/value.h"
 #include "utils/builtins.h"
 #include "utils/guc.h"
+#include "utils/varlena.h"
 
 typedef struct TbFdwOption
 {
@@ -37,6 +38,12 @@ typedef struct TbFdwOption
 #define TB_FDW_OPTION_ARRAY_END {NULL, NULL, false, false, false}
 /* TODO: maximum value for fetch_size? */
 #define TB_FDW_MAX_FETCH_SIZE INT32_MAX
+/* Upper bound of rows bound to one array execution of a modify statement */
+#define TB_FDW_MAX_BATCH_SIZE 65536
+/* Upper bound of prepared statement handles kept open on one connection */
+#define TB_FDW_MAX_STMT_CACHE_SIZE 1024
+/* Upper bound of connection time limits, kept within an int of milliseconds */
+#define TB_FDW_MAX_CONNECTION_SECONDS (INT32_MAX / 1000)
 
 static inline void validate_foreign_server_options(const List *input);
 static inline void validate_foreign_table_options(const List *input);
@@ -52,6 +59,21 @@ static void validate_host_option(DefElem *def);
 static void validate_port_option(DefElem *def);
 static void validate_dbname_option(DefElem *def);
 static void validate_fetch_size_option(DefElem *def);
+static void validate_batch_size_option(DefElem *def);
+static void validate_stmt_cache_size_option(DefElem *def);
+static void validate_tsn_reuse_interval_option(DefElem *def);
+static void validate_connect_timeout_option(DefElem *def);
+static void validate_idle_timeout_option(DefElem *def);
+static void validate_max_lifetime_option(DefElem *def);
+static void validate_max_concurrent_queries_option(DefElem *def);
+static void validate_queue_timeout_option(DefElem *def);
+static void validate_circuit_failures_option(DefElem *def);
+static void validate_circuit_cooldown_option(DefElem *def);
+static void validate_hosts_option(DefElem *def);
+static void validate_standby_hosts_option(DefElem *def);
+static void validate_host_policy_option(DefElem *def);
+static void validate_bulk_load_option(DefElem *def);
+static void validate_bulk_load_commit_size_option(DefElem *def);
 static void validate_username_option(DefElem *def);
 static void validate_password_option(DefElem *def);
 static void validate_owner_name_option(DefElem *def);
@@ -61,10 +83,15 @@ static void validate_use_fb_query_option(DefElem *def);
 static void validate_keep_connections_option(DefElem *def);
 static void validate_password_required_option(DefElem *def);
 static void validate_updatable_option(DefElem *def);
+static void validate_truncatable_option(DefElem *def);
 static void validate_column_name_option(DefElem *def);
+static void validate_key_option(DefElem *def);
 
 static inline char * get_str_value_with_null_check(DefElem *def);
 static inline bool get_bool_value_with_null_check(DefElem *def);
+static inline int get_positive_int_value_with_check(DefElem *def, int max_value);
+static inline int get_non_negative_int_value_with_check(DefElem *def, int max_value);
+static inline void check_endpoint_list(DefElem *def);
 
 PG_FUNCTION_INFO_V1(tibero_fdw_validator);
 
@@ -126,11 +153,25 @@ validate_foreign_server_options(const List *options)
 		TB_FDW_OPTION(host, false, true),
 		TB_FDW_OPTION(port, false, true),
 		TB_FDW_OPTION(dbname, false, true),
+		TB_FDW_OPTION(hosts, false, false),
+		TB_FDW_OPTION(standby_hosts, false, false),
+		TB_FDW_OPTION(host_policy, false, false),
+		TB_FDW_OPTION(connect_timeout, false, false),
+		TB_FDW_OPTION(idle_timeout, false, false),
+		TB_FDW_OPTION(max_lifetime, false, false),
+		TB_FDW_OPTION(max_concurrent_queries, false, false),
+		TB_FDW_OPTION(queue_timeout, false, false),
+		TB_FDW_OPTION(circuit_failures, false, false),
+		TB_FDW_OPTION(circuit_cooldown, false, false),
 		TB_FDW_OPTION(fetch_size, false, false),
+		TB_FDW_OPTION(batch_size, false, false),
+		TB_FDW_OPTION(stmt_cache_size, false, false),
 		TB_FDW_OPTION(use_sleep_on_sig, true, false),
 		TB_FDW_OPTION(use_fb_query, true, false),
+		TB_FDW_OPTION(tsn_reuse_interval, true, false),
 		TB_FDW_OPTION(keep_connections, true, false),
 		TB_FDW_OPTION(updatable, true, false),
+		TB_FDW_OPTION(truncatable, false, false),
 		TB_FDW_OPTION_ARRAY_END
 	};
 	validate_options(foreign_server_options, options);
@@ -143,8 +184,12 @@ validate_foreign_table_options(const List *options)
 		TB_FDW_OPTION(owner_name, false, false),
 		TB_FDW_OPTION(table_name, false, true),
 		TB_FDW_OPTION(fetch_size, false, false),
+		TB_FDW_OPTION(batch_size, false, false),
+		TB_FDW_OPTION(bulk_load, false, false),
+		TB_FDW_OPTION(bulk_load_commit_size, false, false),
 		TB_FDW_OPTION(use_fb_query, true, false),
 		TB_FDW_OPTION(updatable, true, false),
+		TB_FDW_OPTION(truncatable, false, false),
 		TB_FDW_OPTION_ARRAY_END
 	};
 	validate_options(foreign_table_options, options);
@@ -167,6 +212,7 @@ validate_attribute_options(const List *options)
 {
 	TbFdwOption attribute_options[] = {
 		TB_FDW_OPTION(column_name, false, false),
+		TB_FDW_OPTION(key, false, false),
 		TB_FDW_OPTION_ARRAY_END
 	};
 	validate_options(attribute_options, options);
@@ -275,33 +321,122 @@ validate_dbname_option(DefElem *def)
 static void
 validate_fetch_size_option(DefElem *def)
 {
-	char *value;
-	int int_val;
+	(void) get_positive_int_value_with_check(def, TB_FDW_MAX_FETCH_SIZE);
+}
 
-	value = get_str_value_with_null_check(def);
+static void
+validate_batch_size_option(DefElem *def)
+{
+	(void) get_positive_int_value_with_check(def, TB_FDW_MAX_BATCH_SIZE);
+}
 
-	if (!parse_int(value, &int_val, 0, NULL))
-	{
-		ereport(ERROR,
-			(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
-			errmsg("invalid value for integer option \"%s\": %s", def->defname, value)));
-	}
+static void
+validate_stmt_cache_size_option(DefElem *def)
+{
+	/* Zero disables caching of prepared statements */
+	(void) get_non_negative_int_value_with_check(def, TB_FDW_MAX_STMT_CACHE_SIZE);
+}
 
-	if (int_val <= 0)
-	{
-		ereport(ERROR,
-			(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
-			errmsg("\"%s\" must be an integer value greater than zero", def->defname)));
-	}
+static void
+validate_tsn_reuse_interval_option(DefElem *def)
+{
+	/* Milliseconds, zero takes a TSN for every statement */
+	(void) get_non_negative_int_value_with_check(def, INT32_MAX);
+}
+
+static void
+validate_connect_timeout_option(DefElem *def)
+{
+	/* Seconds, zero waits for the login as long as tbcli does */
+	(void) get_non_negative_int_value_with_check(def, INT32_MAX);
+}
+
+static void
+validate_idle_timeout_option(DefElem *def)
+{
+	/* Seconds, zero keeps an idle connection */
+	(void) get_non_negative_int_value_with_check(def, TB_FDW_MAX_CONNECTION_SECONDS);
+}
+
+static void
+validate_max_lifetime_option(DefElem *def)
+{
+	/* Seconds, zero keeps a connection for the life of the backend */
+	(void) get_non_negative_int_value_with_check(def, TB_FDW_MAX_CONNECTION_SECONDS);
+}
+
+static void
+validate_max_concurrent_queries_option(DefElem *def)
+{
+	/* Zero does not limit queries */
+	(void) get_non_negative_int_value_with_check(def, INT32_MAX);
+}
+
+static void
+validate_queue_timeout_option(DefElem *def)
+{
+	/*
+	 * Milliseconds. A statement waits for a slot while holding the slots of the servers its earlier
+	 * scans use, so an unbounded wait could deadlock two backends joining the same servers.
+	 */
+	(void) get_positive_int_value_with_check(def, INT32_MAX);
+}
+
+static void
+validate_circuit_failures_option(DefElem *def)
+{
+	/* Zero keeps trying to connect however many connections failed */
+	(void) get_non_negative_int_value_with_check(def, INT32_MAX);
+}
+
+static void
+validate_circuit_cooldown_option(DefElem *def)
+{
+	/* Seconds */
+	(void) get_positive_int_value_with_check(def, TB_FDW_MAX_CONNECTION_SECONDS);
+}
+
+static void
+validate_hosts_option(DefElem *def)
+{
+	/* Endpoints tried after host and port, as host_policy picks */
+	check_endpoint_list(def);
+}
+
+static void
+validate_standby_hosts_option(DefElem *def)
+{
+	/* Endpoints connected to by read-only transactions */
+	check_endpoint_list(def);
+}
+
+static void
+validate_host_policy_option(DefElem *def)
+{
+	char *value = get_str_value_with_null_check(def);
 
-	if (int_val >= TB_FDW_MAX_FETCH_SIZE)
+	if (strcmp(value, "failover") != 0 && strcmp(value, "round_robin") != 0 &&
+			strcmp(value, "least_connections") != 0)
 	{
 		ereport(ERROR,
 			(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
-			errmsg("\"%s\" exceeded the maximum value", def->defname)));
+			errmsg("invalid value for option \"%s\": \"%s\"", def->defname, value),
+			errhint("Valid values are: failover, round_robin, least_connections")));
 	}
 }
 
+static void
+validate_bulk_load_option(DefElem *def)
+{
+	(void) get_bool_value_with_null_check(def);
+}
+
+static void
+validate_bulk_load_commit_size_option(DefElem *def)
+{
+	(void) get_positive_int_value_with_check(def, INT32_MAX);
+}
+
 static void
 validate_username_option(DefElem *def)
 {
@@ -326,6 +461,12 @@ validate_updatable_option(DefElem *def)
 	(void) get_bool_value_with_null_check(def);
 }
 
+static void
+validate_truncatable_option(DefElem *def)
+{
+	(void) get_bool_value_with_null_check(def);
+}
+
 static void
 validate_owner_name_option(DefElem *def)
 {
@@ -362,6 +503,12 @@ validate_column_name_option(DefElem *def)
 	(void) get_str_value_with_null_check(def);
 }
 
+static void
+validate_key_option(DefElem *def)
+{
+	(void) get_bool_value_with_null_check(def);
+}
+
 static inline char *
 get_str_value_with_null_check(DefElem *def)
 {
@@ -391,3 +538,133 @@ get_bool_value_with_null_check(DefElem *def)
 
 	return defGetBoolean(def);
 }
+
+static inline int
+get_positive_int_value_with_check(DefElem *def, int max_value)
+{
+	char *value;
+	int int_val;
+
+	value = get_str_value_with_null_check(def);
+
+	if (!parse_int(value, &int_val, 0, NULL))
+	{
+		ereport(ERROR,
+			(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+			errmsg("invalid value for integer option \"%s\": %s", def->defname, value)));
+	}
+
+	if (int_val <= 0)
+	{
+		ereport(ERROR,
+			(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+			errmsg("\"%s\" must be an integer value greater than zero", def->defname)));
+	}
+
+	if (int_val > max_value)
+	{
+		ereport(ERROR,
+			(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+			errmsg("\"%s\" exceeded the maximum value", def->defname)));
+	}
+
+	return int_val;
+}
+
+static inline int
+get_non_negative_int_value_with_check(DefElem *def, int max_value)
+{
+	char *value;
+	int int_val;
+
+	value = get_str_value_with_null_check(def);
+
+	if (!parse_int(value, &int_val, 0, NULL))
+	{
+		ereport(ERROR,
+			(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+			errmsg("invalid value for integer option \"%s\": %s", def->defname, value)));
+	}
+
+	if (int_val < 0)
+	{
+		ereport(ERROR,
+			(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+			errmsg("\"%s\" must be an integer value greater than or equal to zero", def->defname)));
+	}
+
+	if (int_val > max_value)
+	{
+		ereport(ERROR,
+			(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+			errmsg("\"%s\" exceeded the maximum value", def->defname)));
+	}
+
+	return int_val;
+}
+
+static inline void
+check_endpoint_list(DefElem *def)
+{
+	char *value = get_str_value_with_null_check(def);
+	List *hosts;
+	List *ports;
+
+	if (!parse_tb_endpoints(value, &hosts, &ports))
+	{
+		ereport(ERROR,
+			(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+			errmsg("invalid value for option \"%s\": \"%s\"", def->defname, value),
+			errhint("Specify a comma-separated list of host[:port] entries.")));
+	}
+
+	if (list_length(hosts) > TB_FDW_MAX_HOSTS)
+	{
+		ereport(ERROR,
+			(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+			errmsg("\"%s\" must not list more than %d hosts", def->defname, TB_FDW_MAX_HOSTS)));
+	}
+}
+
+/*
+ * Splits a comma-separated list of "host[:port]" endpoints into hosts and ports, a port being NULL
+ * where the port option applies. A host with several colons is taken as an IPv6 address without a
+ * port. Returns false for a malformed list.
+ */
+bool
+parse_tb_endpoints(const char *value, List **hosts, List **ports)
+{
+	char *rawstring = pstrdup(value);
+	List *items;
+	ListCell *lc;
+
+	*hosts = NIL;
+	*ports = NIL;
+
+	if (!SplitGUCList(rawstring, ',', &items) || items == NIL)
+		return false;
+
+	foreach(lc, items)
+	{
+		char *host = (char *) lfirst(lc);
+		char *port = strrchr(host, ':');
+
+		if (port != NULL && strchr(host, ':') == port)
+		{
+			*port++ = '\0';
+			if (*port == '\0' || strspn(port, "0123456789") != strlen(port) ||
+					strlen(port) >= TB_ENDPOINT_PORT_LEN)
+				return false;
+		}
+		else
+			port = NULL;
+
+		if (*host == '\0' || strlen(host) >= TB_ENDPOINT_HOST_LEN)
+			return false;
+
+		*hosts = lappend(*hosts, host);
+		*ports = lappend(*ports, port);
+	}
+
+	return true;
+}
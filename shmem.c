@@ -0,0 +1,665 @@
+/*--------------------------------------------------------------------------------------------------
+ *
+ * shmem.c
+ *			State of foreign servers shared by the backends of tibero_fdw
+ *
+ * Portions Copyright (c) 2022-2023, Tmax OpenSQL Research & Development Team
+ *
+ * IDENTIFICATION
+ *			contrib/tibero_fdw/shmem.c
+ *
+ *--------------------------------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include <limits.h>
+
+#include "miscadmin.h"														/* MyDatabaseId																	*/
+#include "pgstat.h"																/* PG_WAIT_EXTENSION														*/
+#include "storage/condition_variable.h"						/* ConditionVariable														*/
+#include "storage/ipc.h"													/* shmem_startup_hook														*/
+#include "storage/lwlock.h"												/* LWLock																				*/
+#include "storage/shmem.h"												/* ShmemInitHash																*/
+#if PG_VERSION_NUM >= 170000
+#include "utils/wait_event.h"											/* WaitEventExtensionNew												*/
+#endif
+#include "utils/guc.h"														/* DefineCustomIntVariable											*/
+#include "utils/hsearch.h"												/* HTAB																					*/
+#include "utils/timestamp.h"											/* TimestampTzPlusMilliseconds									*/
+
+#include "tibero_fdw.h"
+
+/* Foreign servers of all databases tracked at once; a server beyond this is not limited */
+#define TB_FDW_MAX_SHARED_SERVERS 256
+
+typedef struct TbServerShmemKey
+{
+	Oid dbid;
+	Oid serverid;
+} TbServerShmemKey;
+
+typedef struct TbServerShmemEntry
+{
+	TbServerShmemKey key;
+
+	/* Tibero sessions open to the server from all backends */
+	int sessions;
+
+	/* Backends running queries on the server */
+	int queries;
+
+	/* Connections that failed in a row, and until when no connection is tried once they are many */
+	int connect_failures;
+	TimestampTz circuit_open_until;
+
+	/* Next endpoint of a round-robin server, and the sessions open to each endpoint */
+	uint32 next_endpoint;
+	int endpoint_sessions[TB_FDW_MAX_ENDPOINTS];
+
+	/* Signalled when a session or a query slot is given back */
+	ConditionVariable cv;
+} TbServerShmemEntry;
+
+/*
+ * Sessions and query slots this backend holds on each server, given back when it exits. Statements
+ * of the backend on one server share a single query slot, counted here by the statements.
+ */
+typedef struct TbLocalServerEntry
+{
+	TbServerShmemKey key;
+	int sessions;
+	int queries;
+	int endpoint_sessions[TB_FDW_MAX_ENDPOINTS];
+} TbLocalServerEntry;
+
+/* {{{ global variables ***************************************************************************/
+static int max_sessions_per_server = 0;
+static int session_wait_timeout = 30000;
+
+static HTAB *ServerShmemHash = NULL;
+static LWLock *server_shmem_lock = NULL;
+static HTAB *LocalServerHash = NULL;
+
+static uint32 session_wait_event = 0;
+static uint32 query_wait_event = 0;
+
+#if PG_VERSION_NUM >= 150000
+static shmem_request_hook_type prev_shmem_request_hook = NULL;
+#endif
+static shmem_startup_hook_type prev_shmem_startup_hook = NULL;
+/*************************************************************************** global variables }}} */
+
+static void tb_shmem_request(void);
+static void tb_shmem_startup(void);
+static TbServerShmemEntry *get_server_shmem_entry(Oid serverid);
+static TbLocalServerEntry *get_local_server_entry(Oid serverid);
+static uint32 get_wait_event(uint32 *wait_event, const char *name);
+static void give_back_server_shmem(TbServerShmemKey *key, int sessions, int queries);
+static void release_local_servers(int code, Datum arg);
+
+/*
+ * Defines the parameters of the shared server state and reserves its shared memory. The state
+ * exists only when the library is in shared_preload_libraries; otherwise nothing is limited.
+ */
+void
+init_tb_shmem(void)
+{
+	DefineCustomIntVariable("tibero_fdw.max_sessions_per_server",
+													"Maximum number of Tibero sessions all backends open to one foreign server.",
+													"Zero does not limit sessions. Takes effect only when tibero_fdw is in "
+													"shared_preload_libraries.",
+													&max_sessions_per_server,
+													0,
+													0,
+													INT_MAX,
+													PGC_SIGHUP,
+													0,
+													NULL, NULL, NULL);
+
+	DefineCustomIntVariable("tibero_fdw.session_wait_timeout",
+													"Maximum time to wait for a Tibero session of a foreign server.",
+													"A connection waiting longer while max_sessions_per_server sessions are "
+													"open fails. Zero fails at once.",
+													&session_wait_timeout,
+													30000,
+													0,
+													INT_MAX,
+													PGC_USERSET,
+													GUC_UNIT_MS,
+													NULL, NULL, NULL);
+
+	if (!process_shared_preload_libraries_in_progress)
+		return;
+
+#if PG_VERSION_NUM >= 150000
+	prev_shmem_request_hook = shmem_request_hook;
+	shmem_request_hook = tb_shmem_request;
+#else
+	tb_shmem_request();
+#endif
+	prev_shmem_startup_hook = shmem_startup_hook;
+	shmem_startup_hook = tb_shmem_startup;
+}
+
+static void
+tb_shmem_request(void)
+{
+#if PG_VERSION_NUM >= 150000
+	if (prev_shmem_request_hook)
+		prev_shmem_request_hook();
+#endif
+
+	RequestAddinShmemSpace(hash_estimate_size(TB_FDW_MAX_SHARED_SERVERS,
+																						sizeof(TbServerShmemEntry)));
+	RequestNamedLWLockTranche("tibero_fdw", 1);
+}
+
+static void
+tb_shmem_startup(void)
+{
+	HASHCTL info;
+
+	if (prev_shmem_startup_hook)
+		prev_shmem_startup_hook();
+
+	LWLockAcquire(AddinShmemInitLock, LW_EXCLUSIVE);
+
+	info.keysize = sizeof(TbServerShmemKey);
+	info.entrysize = sizeof(TbServerShmemEntry);
+	ServerShmemHash = ShmemInitHash("tibero_fdw servers", TB_FDW_MAX_SHARED_SERVERS,
+																	TB_FDW_MAX_SHARED_SERVERS, &info, HASH_ELEM | HASH_BLOBS);
+	server_shmem_lock = &(GetNamedLWLockTranche("tibero_fdw"))->lock;
+
+	LWLockRelease(AddinShmemInitLock);
+}
+
+/*
+ * Finds the shared entry of the server, adding it on first use. Returns NULL when the shared state
+ * is not available or is full. The caller holds the lock exclusively.
+ */
+static TbServerShmemEntry *
+get_server_shmem_entry(Oid serverid)
+{
+	TbServerShmemKey key;
+	TbServerShmemEntry *entry;
+	bool found;
+
+	key.dbid = MyDatabaseId;
+	key.serverid = serverid;
+
+	entry = hash_search(ServerShmemHash, &key, HASH_ENTER_NULL, &found);
+	if (entry != NULL && !found) {
+		entry->sessions = 0;
+		entry->queries = 0;
+		entry->connect_failures = 0;
+		entry->circuit_open_until = 0;
+		entry->next_endpoint = 0;
+		memset(entry->endpoint_sessions, 0, sizeof(entry->endpoint_sessions));
+		ConditionVariableInit(&entry->cv);
+	}
+
+	return entry;
+}
+
+static TbLocalServerEntry *
+get_local_server_entry(Oid serverid)
+{
+	TbServerShmemKey key;
+	TbLocalServerEntry *local;
+	bool found;
+
+	if (LocalServerHash == NULL) {
+		HASHCTL ctl;
+		ctl.keysize = sizeof(TbServerShmemKey);
+		ctl.entrysize = sizeof(TbLocalServerEntry);
+		LocalServerHash = hash_create("tibero_fdw local servers", 8, &ctl, HASH_ELEM | HASH_BLOBS);
+
+		on_shmem_exit(release_local_servers, (Datum) 0);
+	}
+
+	key.dbid = MyDatabaseId;
+	key.serverid = serverid;
+
+	local = hash_search(LocalServerHash, &key, HASH_ENTER, &found);
+	if (!found) {
+		local->sessions = 0;
+		local->queries = 0;
+		memset(local->endpoint_sessions, 0, sizeof(local->endpoint_sessions));
+	}
+
+	return local;
+}
+
+static uint32
+get_wait_event(uint32 *wait_event, const char *name)
+{
+#if PG_VERSION_NUM >= 170000
+	if (*wait_event == 0)
+		*wait_event = WaitEventExtensionNew(name);
+#else
+	*wait_event = PG_WAIT_EXTENSION;
+#endif
+	return *wait_event;
+}
+
+/*
+ * Takes one of the sessions allowed to the server before connecting to it, waiting while all of
+ * them are in use by other backends. A wait longer than session_wait_timeout fails, since the
+ * backend may hold sessions of other servers that the backends it waits for need. Without wait,
+ * returns false at once when no session is free. *counted tells whether a session was counted, and
+ * so has to be given back with release_tb_session().
+ */
+bool
+acquire_tb_session(Oid serverid, const char *servername, bool wait, bool *counted)
+{
+	TbServerShmemEntry *entry;
+	TbLocalServerEntry *local;
+	TimestampTz deadline;
+
+	*counted = false;
+
+	if (ServerShmemHash == NULL || max_sessions_per_server <= 0)
+		return true;
+
+	local = get_local_server_entry(serverid);
+	deadline = TimestampTzPlusMilliseconds(GetCurrentTimestamp(), session_wait_timeout);
+
+	for (;;) {
+		long remaining;
+
+		LWLockAcquire(server_shmem_lock, LW_EXCLUSIVE);
+
+		entry = get_server_shmem_entry(serverid);
+		if (entry == NULL) {
+			LWLockRelease(server_shmem_lock);
+			ConditionVariableCancelSleep();
+			return true;
+		}
+
+		if (entry->sessions < max_sessions_per_server) {
+			entry->sessions++;
+			local->sessions++;
+			LWLockRelease(server_shmem_lock);
+			break;
+		}
+
+		LWLockRelease(server_shmem_lock);
+
+		if (!wait) {
+			ConditionVariableCancelSleep();
+			return false;
+		}
+
+		remaining = TimestampDifferenceMilliseconds(GetCurrentTimestamp(), deadline);
+		if (remaining <= 0 ||
+				ConditionVariableTimedSleep(&entry->cv, remaining,
+																		get_wait_event(&session_wait_event, "TiberoFdwSession"))) {
+			ConditionVariableCancelSleep();
+			ereport(ERROR,
+							(errcode(ERRCODE_CONFIGURATION_LIMIT_EXCEEDED),
+							 errmsg("timed out waiting for a session of server \"%s\"", servername),
+							 errdetail("%d sessions are open to the server.", max_sessions_per_server)));
+		}
+	}
+	ConditionVariableCancelSleep();
+	*counted = true;
+
+	return true;
+}
+
+/*
+ * Returns whether all the sessions allowed to the server are open, so that a backend keeping an
+ * idle one gives it back to those that may be waiting.
+ */
+bool
+tb_session_limit_reached(Oid serverid)
+{
+	TbServerShmemKey key;
+	TbServerShmemEntry *entry;
+	bool reached = false;
+
+	if (ServerShmemHash == NULL || max_sessions_per_server <= 0)
+		return false;
+
+	key.dbid = MyDatabaseId;
+	key.serverid = serverid;
+
+	LWLockAcquire(server_shmem_lock, LW_SHARED);
+	entry = hash_search(ServerShmemHash, &key, HASH_FIND, NULL);
+	if (entry != NULL)
+		reached = (entry->sessions >= max_sessions_per_server);
+	LWLockRelease(server_shmem_lock);
+
+	return reached;
+}
+
+/*
+ * Gives back a session counted by acquire_tb_session(), waking the backends waiting for one.
+ */
+void
+release_tb_session(Oid serverid)
+{
+	TbLocalServerEntry *local;
+
+	if (ServerShmemHash == NULL || LocalServerHash == NULL)
+		return;
+
+	local = get_local_server_entry(serverid);
+	if (local->sessions == 0)
+		return;
+
+	local->sessions--;
+	give_back_server_shmem(&local->key, 1, 0);
+}
+
+/*
+ * Takes the query slot of the server for a statement, waiting while max_queries other backends run
+ * queries on it. Further statements of the backend on the server share the slot, so a query that
+ * scans several tables of one server never waits for itself. A query scanning several servers waits
+ * while holding the slots of those it scans already, so a wait longer than queue_timeout
+ * milliseconds fails rather than deadlocking. Returns whether the statement was counted, and so has
+ * to give the slot back with release_tb_query_slot().
+ */
+bool
+acquire_tb_query_slot(Oid serverid, const char *servername, int max_queries, int queue_timeout)
+{
+	TbServerShmemEntry *entry;
+	TbLocalServerEntry *local;
+	TimestampTz deadline;
+
+	if (ServerShmemHash == NULL || max_queries <= 0)
+		return false;
+
+	local = get_local_server_entry(serverid);
+	if (local->queries > 0) {
+		local->queries++;
+		return true;
+	}
+
+	deadline = TimestampTzPlusMilliseconds(GetCurrentTimestamp(), queue_timeout);
+
+	for (;;) {
+		long remaining;
+
+		LWLockAcquire(server_shmem_lock, LW_EXCLUSIVE);
+
+		entry = get_server_shmem_entry(serverid);
+		if (entry == NULL) {
+			LWLockRelease(server_shmem_lock);
+			ConditionVariableCancelSleep();
+			return false;
+		}
+
+		if (entry->queries < max_queries) {
+			entry->queries++;
+			local->queries++;
+			LWLockRelease(server_shmem_lock);
+			break;
+		}
+
+		LWLockRelease(server_shmem_lock);
+
+		remaining = TimestampDifferenceMilliseconds(GetCurrentTimestamp(), deadline);
+		if (remaining <= 0 ||
+				ConditionVariableTimedSleep(&entry->cv, remaining,
+																		get_wait_event(&query_wait_event, "TiberoFdwQuery"))) {
+			ConditionVariableCancelSleep();
+			ereport(ERROR,
+							(errcode(ERRCODE_CONFIGURATION_LIMIT_EXCEEDED),
+							 errmsg("timed out waiting for a query slot of server \"%s\"", servername),
+							 errdetail("%d queries are running on the server.", max_queries)));
+		}
+	}
+	ConditionVariableCancelSleep();
+
+	return true;
+}
+
+/*
+ * Gives back the query slot of a statement counted by acquire_tb_query_slot() once no statement of
+ * the backend on the server is left.
+ */
+void
+release_tb_query_slot(Oid serverid)
+{
+	TbLocalServerEntry *local;
+
+	if (ServerShmemHash == NULL || LocalServerHash == NULL)
+		return;
+
+	local = get_local_server_entry(serverid);
+	if (local->queries == 0)
+		return;
+
+	if (--local->queries == 0)
+		give_back_server_shmem(&local->key, 0, 1);
+}
+
+/*
+ * Gives back the query slots left by statements that were not released, as at abort. Their
+ * statements are not used after the transaction, so the counts are simply reset.
+ */
+void
+release_tb_query_slots(void)
+{
+	HASH_SEQ_STATUS scan;
+	TbLocalServerEntry *local;
+
+	if (LocalServerHash == NULL)
+		return;
+
+	hash_seq_init(&scan, LocalServerHash);
+	while ((local = (TbLocalServerEntry *) hash_seq_search(&scan))) {
+		if (local->queries > 0) {
+			local->queries = 0;
+			give_back_server_shmem(&local->key, 0, 1);
+		}
+	}
+}
+
+/*
+ * Fails fast instead of connecting to a server that failed max_failures connections in a row, until
+ * cooldown seconds have passed since the last failure. The first backend to connect after that
+ * probes the server, while the others keep failing fast for another cooldown; a probe that does not
+ * report back, as when its backend exits, lets the next one try after it. Unless raise_error, a
+ * server that may not be connected to returns false instead of failing.
+ */
+bool
+check_tb_circuit(Oid serverid, const char *servername, int max_failures, int cooldown,
+								 bool raise_error)
+{
+	TbServerShmemEntry *entry;
+	TimestampTz now;
+	TimestampTz open_until = 0;
+	int failures = 0;
+
+	if (ServerShmemHash == NULL || max_failures <= 0)
+		return true;
+
+	now = GetCurrentTimestamp();
+
+	LWLockAcquire(server_shmem_lock, LW_EXCLUSIVE);
+	entry = get_server_shmem_entry(serverid);
+	if (entry != NULL && entry->connect_failures >= max_failures) {
+		failures = entry->connect_failures;
+		open_until = entry->circuit_open_until;
+		if (now >= open_until)
+			entry->circuit_open_until = TimestampTzPlusMilliseconds(now, cooldown * 1000);
+	}
+	LWLockRelease(server_shmem_lock);
+
+	if (now < open_until) {
+		long secs;
+		int usecs;
+
+		if (!raise_error)
+			return false;
+
+		TimestampDifference(now, open_until, &secs, &usecs);
+		ereport(ERROR,
+						(errcode(ERRCODE_FDW_UNABLE_TO_ESTABLISH_CONNECTION),
+						 errmsg("could not connect to server \"%s\"", servername),
+						 errdetail("%d connections to the server failed in a row; it is tried again in %ld seconds.",
+											 failures, secs + (usecs > 0 ? 1 : 0))));
+	}
+
+	return true;
+}
+
+/*
+ * Counts a failed connection to the server, opening its circuit at max_failures, or closes the
+ * circuit after a connection succeeded.
+ */
+void
+report_tb_connect_result(Oid serverid, bool succeeded, int max_failures, int cooldown)
+{
+	TbServerShmemEntry *entry;
+
+	if (ServerShmemHash == NULL || max_failures <= 0)
+		return;
+
+	LWLockAcquire(server_shmem_lock, LW_EXCLUSIVE);
+	entry = get_server_shmem_entry(serverid);
+	if (entry != NULL) {
+		if (succeeded) {
+			entry->connect_failures = 0;
+			entry->circuit_open_until = 0;
+		} else if (++entry->connect_failures >= max_failures) {
+			entry->circuit_open_until = TimestampTzPlusMilliseconds(GetCurrentTimestamp(),
+																															cooldown * 1000);
+		}
+	}
+	LWLockRelease(server_shmem_lock);
+}
+
+/*
+ * Returns the next endpoint in turn of a round-robin server among all backends, to be taken modulo
+ * the number of endpoints, or -1 when the shared state is not available.
+ */
+int
+next_tb_endpoint(Oid serverid)
+{
+	TbServerShmemEntry *entry;
+	int next = -1;
+
+	if (ServerShmemHash == NULL)
+		return -1;
+
+	LWLockAcquire(server_shmem_lock, LW_EXCLUSIVE);
+	entry = get_server_shmem_entry(serverid);
+	if (entry != NULL)
+		next = (int) (entry->next_endpoint++ & INT_MAX);
+	LWLockRelease(server_shmem_lock);
+
+	return next;
+}
+
+/*
+ * Copies the sessions all backends have open to each endpoint of the server. Returns false when the
+ * shared state is not available.
+ */
+bool
+get_tb_endpoint_sessions(Oid serverid, int *sessions)
+{
+	TbServerShmemEntry *entry;
+
+	if (ServerShmemHash == NULL)
+		return false;
+
+	LWLockAcquire(server_shmem_lock, LW_EXCLUSIVE);
+	entry = get_server_shmem_entry(serverid);
+	if (entry != NULL)
+		memcpy(sessions, entry->endpoint_sessions, sizeof(entry->endpoint_sessions));
+	LWLockRelease(server_shmem_lock);
+
+	return entry != NULL;
+}
+
+/*
+ * Counts a session open to an endpoint of the server. Returns whether it was counted, and so has to
+ * be given back with remove_tb_endpoint_session().
+ */
+bool
+add_tb_endpoint_session(Oid serverid, int endpoint)
+{
+	TbServerShmemEntry *entry;
+	TbLocalServerEntry *local;
+
+	if (ServerShmemHash == NULL)
+		return false;
+
+	local = get_local_server_entry(serverid);
+
+	LWLockAcquire(server_shmem_lock, LW_EXCLUSIVE);
+	entry = get_server_shmem_entry(serverid);
+	if (entry != NULL) {
+		entry->endpoint_sessions[endpoint]++;
+		local->endpoint_sessions[endpoint]++;
+	}
+	LWLockRelease(server_shmem_lock);
+
+	return entry != NULL;
+}
+
+void
+remove_tb_endpoint_session(Oid serverid, int endpoint)
+{
+	TbServerShmemEntry *entry;
+	TbLocalServerEntry *local;
+
+	if (ServerShmemHash == NULL || LocalServerHash == NULL)
+		return;
+
+	local = get_local_server_entry(serverid);
+	if (local->endpoint_sessions[endpoint] == 0)
+		return;
+	local->endpoint_sessions[endpoint]--;
+
+	LWLockAcquire(server_shmem_lock, LW_EXCLUSIVE);
+	entry = hash_search(ServerShmemHash, &local->key, HASH_FIND, NULL);
+	if (entry != NULL && entry->endpoint_sessions[endpoint] > 0)
+		entry->endpoint_sessions[endpoint]--;
+	LWLockRelease(server_shmem_lock);
+}
+
+static void
+give_back_server_shmem(TbServerShmemKey *key, int sessions, int queries)
+{
+	TbServerShmemEntry *entry;
+
+	LWLockAcquire(server_shmem_lock, LW_EXCLUSIVE);
+	entry = hash_search(ServerShmemHash, key, HASH_FIND, NULL);
+	if (entry != NULL) {
+		entry->sessions = Max(entry->sessions - sessions, 0);
+		entry->queries = Max(entry->queries - queries, 0);
+	}
+	LWLockRelease(server_shmem_lock);
+
+	if (entry != NULL)
+		ConditionVariableBroadcast(&entry->cv);
+}
+
+/*
+ * Gives back what an exiting backend holds, as its connections are closed with the process.
+ */
+static void
+release_local_servers(int code, Datum arg)
+{
+	HASH_SEQ_STATUS scan;
+	TbLocalServerEntry *local;
+
+	hash_seq_init(&scan, LocalServerHash);
+	while ((local = (TbLocalServerEntry *) hash_seq_search(&scan))) {
+		int i;
+
+		if (local->sessions > 0 || local->queries > 0)
+			give_back_server_shmem(&local->key, local->sessions, local->queries > 0 ? 1 : 0);
+		local->sessions = 0;
+		local->queries = 0;
+
+		for (i = 0; i < TB_FDW_MAX_ENDPOINTS; i++) {
+			while (local->endpoint_sessions[i] > 0)
+				remove_tb_endpoint_session(local->key.serverid, i);
+		}
+	}
+}
@@ -0,0 +1,72 @@
+-- Start transaction and plan the tests.
+BEGIN;
+  CREATE EXTENSION IF NOT EXISTS pgtap;
+
+  SELECT plan(7);
+
+  CREATE EXTENSION IF NOT EXISTS tibero_fdw;
+
+  CREATE SERVER server_name FOREIGN DATA WRAPPER tibero_fdw
+    OPTIONS (host :'TIBERO_HOST', port :'TIBERO_PORT', dbname :'TIBERO_DB');
+
+  CREATE USER MAPPING FOR current_user
+    SERVER server_name
+    OPTIONS (username :'TIBERO_USER', password :'TIBERO_PASS');
+
+  CREATE SCHEMA import_dest;
+  CREATE SCHEMA import_lower;
+
+  -- TEST 1
+  SELECT throws_matching(
+    format('IMPORT FOREIGN SCHEMA %I FROM SERVER server_name INTO import_dest
+            OPTIONS (wrong_option ''true'')', upper(:'TIBERO_USER')),
+    'invalid option "wrong_option"',
+    'Import foreign schema with an unknown option'
+  );
+
+  -- TEST 2
+  SELECT lives_ok(
+    format('IMPORT FOREIGN SCHEMA %I LIMIT TO (ins_test, st1) FROM SERVER server_name
+            INTO import_dest', upper(:'TIBERO_USER')),
+    'Import foreign schema limited to the given tables'
+  );
+
+  -- TEST 3
+  SELECT set_eq(
+    'SELECT foreign_table_name::TEXT FROM information_schema.foreign_tables
+     WHERE foreign_table_schema = ''import_dest''',
+    ARRAY['ins_test', 'st1'],
+    'Verify only the listed tables are imported'
+  );
+
+  -- TEST 4
+  SELECT columns_are(
+    'import_dest', 'ins_test',
+    ARRAY['c1', 'c2', 'c3', 'c4', 'c5', 'c6', 'c7', 'c8', 'c9', 'c10'],
+    'Verify columns of the imported foreign table'
+  );
+
+  -- TEST 5
+  SELECT lives_ok(
+    'SELECT * FROM import_dest.ins_test',
+    'Check SELECT FROM imported foreign table'
+  );
+
+  -- TEST 6
+  SELECT lives_ok(
+    format('IMPORT FOREIGN SCHEMA %s LIMIT TO (st1) FROM SERVER server_name
+            INTO import_lower', lower(:'TIBERO_USER')),
+    'Import foreign schema named in lower case'
+  );
+
+  -- TEST 7
+  SELECT results_eq(
+    'SELECT count(*)::INT FROM import_lower.st1 WHERE c1 = 100',
+    $$VALUES (1)$$,
+    'Verify the schema named in lower case is folded to the remote schema'
+  );
+
+  -- Finish the tests and clean up.
+  SELECT * FROM finish();
+
+ROLLBACK;
@@ -0,0 +1,116 @@
+-- Start transaction and plan the tests.
+BEGIN;
+  CREATE EXTENSION IF NOT EXISTS pgtap;
+
+  SELECT plan(11);
+
+  CREATE EXTENSION IF NOT EXISTS tibero_fdw;
+
+  CREATE SERVER server_name FOREIGN DATA WRAPPER tibero_fdw
+    OPTIONS (host :'TIBERO_HOST', port :'TIBERO_PORT', dbname :'TIBERO_DB', batch_size '4');
+
+  CREATE USER MAPPING FOR current_user
+    SERVER server_name
+    OPTIONS (username :'TIBERO_USER', password :'TIBERO_PASS');
+
+  CREATE FOREIGN TABLE fins_test (
+    c1 INT,
+    c2 VARCHAR(10),
+    c3 CHAR(9),
+    c4 BIGINT,
+    c5 DATE,
+    c6 DECIMAL(10,5),
+    c7 INT,
+    c8 SMALLINT,
+    c9 NCHAR(9),
+    c10 TEXT
+  ) server server_name options (owner_name :'TIBERO_USER', table_name 'ins_test', updatable 'on');
+
+  -- TEST 1:
+  SELECT throws_matching(
+    'ALTER SERVER server_name OPTIONS (SET batch_size ''0'')',
+    'must be an integer value greater than zero',
+    'Check batch_size option rejects non-positive value'
+  );
+
+  -- TEST 2:
+  SELECT lives_ok('
+    INSERT INTO fins_test (c1, c2, c4, c10)
+    SELECT i, ''B'' || i, i * 100, NULL FROM generate_series(1, 10) i;',
+    'Insert rows in batches of the server batch_size'
+  );
+
+  -- TEST 3:
+  SELECT results_eq('
+    SELECT c1, c2, c4, c10 FROM fins_test WHERE c1 <= 10 ORDER BY c1;',
+    $$SELECT i, ('B' || i)::VARCHAR, (i * 100)::BIGINT, NULL::TEXT FROM generate_series(1, 10) i$$,
+    'Verify every row of a partially filled last batch is inserted'
+  );
+
+  -- TEST 4:
+  ALTER FOREIGN TABLE fins_test OPTIONS (ADD batch_size '1');
+  SELECT lives_ok('
+    INSERT INTO fins_test (c1, c2) VALUES (11, ''S1''), (12, ''S2'');',
+    'Insert rows one at a time with table batch_size overriding the server option'
+  );
+
+  -- TEST 5:
+  SELECT is(
+    (SELECT COUNT(*) FROM fins_test WHERE c1 IN (11, 12))::integer,
+    2,
+    'Verify every row is inserted when batching is disabled'
+  );
+
+  -- TEST 6:
+  SELECT is(
+    (SELECT COUNT(*) FROM pg_catalog.pg_foreign_table
+      WHERE ftrelid = 'fins_test'::regclass
+        AND ftoptions @> array['batch_size=1'])::integer,
+    1,
+    'Check batch_size option of ALTER FOREIGN TABLE command is saved on pg_foreign_table catalog'
+  );
+
+  -- TEST 7:
+  SELECT throws_ok(
+    'INSERT INTO fins_test (c1, c5) VALUES (11, ''40000-01-01''::DATE)',
+    '22008',
+    'timestamp out of range for remote table',
+    'Check year that does not fit the remote timestamp is rejected'
+  );
+
+  -- TEST 8:
+  SELECT throws_ok(
+    'INSERT INTO fins_test (c1, c5) VALUES (12, ''5000000-01-01''::DATE)',
+    '22008',
+    'date out of range for remote table',
+    'Check date past the end of timestamps is rejected'
+  );
+
+  ALTER FOREIGN TABLE fins_test OPTIONS (DROP batch_size);
+  CREATE VIEW fins_view AS SELECT * FROM fins_test WHERE c1 < 1000 WITH CHECK OPTION;
+
+  -- TEST 9:
+  SELECT throws_ok(
+    'INSERT INTO fins_view (c1, c2) VALUES (21, ''V1''), (2000, ''V2'')',
+    '44000',
+    NULL,
+    'Check rows inserted through a view WITH CHECK OPTION are checked one by one'
+  );
+
+  -- TEST 10:
+  SELECT lives_ok(
+    'ALTER SERVER server_name OPTIONS (SET batch_size ''65536'')',
+    'Check batch_size option accepts its maximum value'
+  );
+
+  -- TEST 11:
+  SELECT throws_matching(
+    'ALTER SERVER server_name OPTIONS (SET batch_size ''65537'')',
+    'exceeded the maximum value',
+    'Check batch_size option rejects value over its maximum'
+  );
+
+  -- Finish the tests and clean up.
+  SELECT * FROM finish();
+
+ROLLBACK;
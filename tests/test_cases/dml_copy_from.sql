@@ -0,0 +1,84 @@
+-- Start transaction and plan the tests.
+BEGIN;
+  CREATE EXTENSION IF NOT EXISTS pgtap;
+
+  SELECT plan(4);
+
+  CREATE EXTENSION IF NOT EXISTS tibero_fdw;
+
+  CREATE SERVER server_name FOREIGN DATA WRAPPER tibero_fdw
+    OPTIONS (host :'TIBERO_HOST', port :'TIBERO_PORT', dbname :'TIBERO_DB', batch_size '2');
+
+  CREATE USER MAPPING FOR current_user
+    SERVER server_name
+    OPTIONS (username :'TIBERO_USER', password :'TIBERO_PASS');
+
+  CREATE FOREIGN TABLE fins_test (
+    c1 INT,
+    c2 VARCHAR(10),
+    c3 CHAR(9),
+    c4 BIGINT,
+    c5 DATE,
+    c6 DECIMAL(10,5),
+    c7 INT,
+    c8 SMALLINT,
+    c9 NCHAR(9),
+    c10 TEXT
+  ) server server_name options (owner_name :'TIBERO_USER', table_name 'ins_test', updatable 'on');
+
+  COPY fins_test (c1, c2, c5) FROM STDIN;
+1	COPY1	2023-01-01
+2	COPY2	2023-01-02
+3	COPY3	\N
+\.
+
+  -- TEST 1:
+  SELECT results_eq('
+    SELECT c1, c2, c5 FROM fins_test WHERE c1 <= 3 ORDER BY c1;',
+    $$VALUES (1, 'COPY1'::VARCHAR, '2023-01-01'::DATE),
+             (2, 'COPY2'::VARCHAR, '2023-01-02'::DATE),
+             (3, 'COPY3'::VARCHAR, NULL::DATE)$$,
+    'Verify rows loaded by COPY FROM into foreign table'
+  );
+
+  CREATE TABLE routed_parent (
+    c1 INT,
+    c2 VARCHAR(10),
+    c3 CHAR(9),
+    c4 BIGINT,
+    c5 DATE,
+    c6 DECIMAL(10,5),
+    c7 INT,
+    c8 SMALLINT,
+    c9 NCHAR(9),
+    c10 TEXT
+  ) PARTITION BY RANGE (c1);
+
+  CREATE TABLE routed_local PARTITION OF routed_parent FOR VALUES FROM (0) TO (100);
+  ALTER TABLE routed_parent ATTACH PARTITION fins_test FOR VALUES FROM (100) TO (200);
+
+  -- TEST 2:
+  SELECT lives_ok('
+    INSERT INTO routed_parent (c1, c2)
+    SELECT i, ''R'' || i FROM generate_series(95, 104) i;',
+    'Insert rows routed into local and foreign partitions'
+  );
+
+  -- TEST 3:
+  SELECT is(
+    (SELECT COUNT(*) FROM fins_test WHERE c1 BETWEEN 100 AND 104)::integer,
+    5,
+    'Verify rows routed into the foreign partition are inserted'
+  );
+
+  -- TEST 4:
+  SELECT is(
+    (SELECT COUNT(*) FROM routed_local)::integer,
+    5,
+    'Verify rows routed into the local partition are inserted'
+  );
+
+  -- Finish the tests and clean up.
+  SELECT * FROM finish();
+
+ROLLBACK;
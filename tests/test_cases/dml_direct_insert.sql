@@ -0,0 +1,74 @@
+-- Start transaction and plan the tests.
+BEGIN;
+  CREATE EXTENSION IF NOT EXISTS pgtap;
+
+  SELECT plan(6);
+
+  CREATE EXTENSION IF NOT EXISTS tibero_fdw;
+
+  CREATE SERVER server_name FOREIGN DATA WRAPPER tibero_fdw
+    OPTIONS (host :'TIBERO_HOST', port :'TIBERO_PORT', dbname :'TIBERO_DB');
+
+  CREATE USER MAPPING FOR current_user
+    SERVER server_name
+    OPTIONS (username :'TIBERO_USER', password :'TIBERO_PASS');
+
+  CREATE FOREIGN TABLE fins_test (
+    c1 INT,
+    c2 VARCHAR(10),
+    c3 CHAR(9)
+  ) server server_name options (owner_name :'TIBERO_USER', table_name 'ins_test', updatable 'on');
+
+  CREATE FOREIGN TABLE fst1 (
+    c1 INT,
+    c2 VARCHAR(10),
+    c3 CHAR(9)
+  ) server server_name options (owner_name :'TIBERO_USER', table_name 'st1');
+
+  -- TEST 1:
+  SELECT lives_ok('
+    INSERT INTO fins_test SELECT c1, c2, c3 FROM fst1 WHERE c1 > 200',
+    'Check INSERT ... SELECT between tables on the same server'
+  );
+
+  -- TEST 2:
+  SELECT results_eq('
+    SELECT c1, c2, c3 FROM fins_test ORDER BY c1',
+    'SELECT c1, c2, c3 FROM fst1 WHERE c1 > 200 ORDER BY c1',
+    'Verify rows inserted by the remote INSERT ... SELECT'
+  );
+
+  -- TEST 3:
+  SELECT lives_ok('
+    INSERT INTO fins_test (c1, c2) SELECT c1 + 1000, ''X'' FROM fst1 WHERE c1 = 100',
+    'Check INSERT ... SELECT with computed and constant columns'
+  );
+
+  -- TEST 4:
+  SELECT results_eq('
+    SELECT c1, c2, c3 FROM fins_test WHERE c1 > 1000',
+    $$VALUES (1100, 'X'::VARCHAR, NULL::CHAR(9))$$,
+    'Verify computed, constant and omitted columns of INSERT ... SELECT'
+  );
+
+  -- The dropped column is left out of the remote INSERT
+  ALTER FOREIGN TABLE fins_test ADD COLUMN c_dropped INT;
+  ALTER FOREIGN TABLE fins_test DROP COLUMN c_dropped;
+
+  -- TEST 5:
+  SELECT lives_ok('
+    INSERT INTO fins_test (c1, c2) SELECT c1 + 2000, c2 FROM fst1 WHERE c1 = 100',
+    'Check INSERT ... SELECT into a table with a dropped column'
+  );
+
+  -- TEST 6:
+  SELECT results_eq('
+    SELECT c1, c2 FROM fins_test WHERE c1 > 2000',
+    'SELECT c1 + 2000, c2 FROM fst1 WHERE c1 = 100',
+    'Verify rows inserted into a table with a dropped column'
+  );
+
+  -- Finish the tests and clean up.
+  SELECT * FROM finish();
+
+ROLLBACK;
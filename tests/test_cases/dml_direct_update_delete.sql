@@ -0,0 +1,87 @@
+-- Start transaction and plan the tests.
+BEGIN;
+  CREATE EXTENSION IF NOT EXISTS pgtap;
+
+  SELECT plan(7);
+
+  CREATE EXTENSION IF NOT EXISTS tibero_fdw;
+
+  CREATE SERVER server_name FOREIGN DATA WRAPPER tibero_fdw
+    OPTIONS (host :'TIBERO_HOST', port :'TIBERO_PORT', dbname :'TIBERO_DB');
+
+  CREATE USER MAPPING FOR current_user
+    SERVER server_name
+    OPTIONS (username :'TIBERO_USER', password :'TIBERO_PASS');
+
+  CREATE FOREIGN TABLE fins_test (
+    c1 INT,
+    c2 VARCHAR(10),
+    c3 CHAR(9)
+  ) server server_name options (owner_name :'TIBERO_USER', table_name 'ins_test', updatable 'on');
+
+  -- Verbose plan of a statement as one text, without running it
+  CREATE FUNCTION pg_temp.explain_verbose(query TEXT) RETURNS TEXT AS $$
+  DECLARE
+    line TEXT;
+    plan TEXT := '';
+  BEGIN
+    FOR line IN EXECUTE 'EXPLAIN (VERBOSE, COSTS OFF) ' || query LOOP
+      plan := plan || line || E'\n';
+    END LOOP;
+    RETURN plan;
+  END;
+  $$ LANGUAGE plpgsql;
+
+  INSERT INTO fins_test (c1, c2, c3)
+  SELECT i, 'D' || i, 'OLD' FROM generate_series(1, 6) i;
+
+  -- TEST 1:
+  SELECT lives_ok('
+    UPDATE fins_test SET c3 = ''NEW'', c1 = c1 + 100 WHERE c1 > 4',
+    'Check UPDATE with shippable SET and WHERE run as a single remote statement'
+  );
+
+  -- TEST 2:
+  SELECT results_eq('
+    SELECT c1, c3 FROM fins_test WHERE c1 > 4 ORDER BY c1',
+    $$VALUES (105, 'NEW'::CHAR(9)), (106, 'NEW'::CHAR(9))$$,
+    'Verify rows updated by the remote UPDATE'
+  );
+
+  -- TEST 3:
+  SELECT matches(
+    pg_temp.explain_verbose('DELETE FROM fins_test WHERE c1 > 100'),
+    'Remote SQL: DELETE FROM',
+    'Verify DELETE with shippable WHERE is planned as a single remote statement'
+  );
+
+  -- TEST 4:
+  SELECT lives_ok('
+    DELETE FROM fins_test WHERE c1 > 100',
+    'Check DELETE with shippable WHERE run as a single remote statement'
+  );
+
+  -- TEST 5:
+  SELECT is(
+    (SELECT COUNT(*) FROM fins_test)::integer,
+    4,
+    'Verify rows deleted by the remote DELETE'
+  );
+
+  -- TEST 6:
+  SELECT lives_ok('
+    UPDATE fins_test SET c2 = upper(c2) || c1 WHERE c1 = 1',
+    'Check UPDATE with a non-shippable SET expression falls back to ROWID'
+  );
+
+  -- TEST 7:
+  SELECT results_eq('
+    SELECT c1, c2 FROM fins_test ORDER BY c1',
+    $$VALUES (1, 'D11'::VARCHAR), (2, 'D2'::VARCHAR), (3, 'D3'::VARCHAR), (4, 'D4'::VARCHAR)$$,
+    'Verify rows updated through ROWID after the fallback'
+  );
+
+  -- Finish the tests and clean up.
+  SELECT * FROM finish();
+
+ROLLBACK;
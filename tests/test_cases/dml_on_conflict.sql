@@ -0,0 +1,87 @@
+-- Start transaction and plan the tests.
+BEGIN;
+  CREATE EXTENSION IF NOT EXISTS pgtap;
+
+  SELECT plan(7);
+
+  CREATE EXTENSION IF NOT EXISTS tibero_fdw;
+
+  CREATE SERVER server_name FOREIGN DATA WRAPPER tibero_fdw
+    OPTIONS (host :'TIBERO_HOST', port :'TIBERO_PORT', dbname :'TIBERO_DB', batch_size '10');
+
+  CREATE USER MAPPING FOR current_user
+    SERVER server_name
+    OPTIONS (username :'TIBERO_USER', password :'TIBERO_PASS');
+
+  CREATE FOREIGN TABLE fst1 (
+    c1 INT,
+    c2 VARCHAR(10)
+  ) server server_name options (owner_name :'TIBERO_USER', table_name 'st1', updatable 'on');
+
+  -- Rows processed by a statement, as the command tag reports them
+  CREATE FUNCTION pg_temp.processed_rows(query TEXT) RETURNS BIGINT AS $$
+  DECLARE
+    processed BIGINT;
+  BEGIN
+    EXECUTE query;
+    GET DIAGNOSTICS processed = ROW_COUNT;
+    RETURN processed;
+  END;
+  $$ LANGUAGE plpgsql;
+
+  -- TEST 1:
+  SELECT throws_matching(
+    'INSERT INTO fst1 VALUES (100, ''DUP'') ON CONFLICT DO NOTHING',
+    'requires a column with the "key" option',
+    'Check ON CONFLICT DO NOTHING without key column is rejected'
+  );
+
+  ALTER FOREIGN TABLE fst1 ALTER COLUMN c1 OPTIONS (ADD key 'true');
+
+  -- TEST 2:
+  SELECT lives_ok(
+    'INSERT INTO fst1 VALUES (100, ''DUP''), (600, ''HS6'') ON CONFLICT DO NOTHING',
+    'Check ON CONFLICT DO NOTHING with existing and new keys'
+  );
+
+  -- TEST 3:
+  SELECT results_eq(
+    'SELECT c1, c2 FROM fst1 WHERE c1 IN (100, 600) ORDER BY c1',
+    $$VALUES (100, 'HS1'::VARCHAR), (600, 'HS6'::VARCHAR)$$,
+    'Verify conflicting row is skipped and new row is inserted'
+  );
+
+  -- TEST 4:
+  SELECT lives_ok(
+    'INSERT INTO fst1 SELECT i * 100, ''B'' || i FROM generate_series(1, 12) i ON CONFLICT DO NOTHING',
+    'Check ON CONFLICT DO NOTHING in batches'
+  );
+
+  -- TEST 5:
+  SELECT is(
+    (SELECT COUNT(*) FROM fst1 WHERE c1 BETWEEN 100 AND 1200)::integer,
+    12,
+    'Verify only non-conflicting rows of the batches are inserted'
+  );
+
+  -- TEST 6:
+  SELECT is(
+    pg_temp.processed_rows('INSERT INTO fst1 SELECT i * 100, ''C'' || i FROM generate_series(1, 15) i
+                            ON CONFLICT DO NOTHING'),
+    3::BIGINT,
+    'Verify rows skipped in batches are not counted as inserted'
+  );
+
+  -- TEST 7:
+  SELECT results_eq(
+    'WITH ins AS (INSERT INTO fst1 VALUES (100, ''DUP''), (1600, ''C16'') ON CONFLICT DO NOTHING
+                  RETURNING c1)
+     SELECT c1 FROM ins',
+    $$VALUES (1600)$$,
+    'Verify skipped row is not returned by a single row insert'
+  );
+
+  -- Finish the tests and clean up.
+  SELECT * FROM finish();
+
+ROLLBACK;
@@ -0,0 +1,71 @@
+-- Start transaction and plan the tests.
+BEGIN;
+  CREATE EXTENSION IF NOT EXISTS pgtap;
+
+  SELECT plan(6);
+
+  CREATE EXTENSION IF NOT EXISTS tibero_fdw;
+
+  CREATE SERVER server_name FOREIGN DATA WRAPPER tibero_fdw
+    OPTIONS (host :'TIBERO_HOST', port :'TIBERO_PORT', dbname :'TIBERO_DB');
+
+  CREATE USER MAPPING FOR current_user
+    SERVER server_name
+    OPTIONS (username :'TIBERO_USER', password :'TIBERO_PASS');
+
+  -- ins_test is used as TRUNCATE commits the remote transaction and cannot be rolled back
+  CREATE FOREIGN TABLE fins_test (
+    c1 INT,
+    c2 VARCHAR(10)
+  ) server server_name options (owner_name :'TIBERO_USER', table_name 'ins_test', updatable 'on');
+
+  -- TEST 1:
+  SELECT throws_matching(
+    'ALTER FOREIGN TABLE fins_test OPTIONS (ADD truncatable ''maybe'')',
+    'requires a Boolean value',
+    'Check truncatable option rejects non-boolean value'
+  );
+
+  -- TEST 2:
+  SELECT throws_matching(
+    'TRUNCATE fins_test CASCADE',
+    'CASCADE is not supported',
+    'Check TRUNCATE ... CASCADE is rejected'
+  );
+
+  -- TEST 3:
+  ALTER SERVER server_name OPTIONS (ADD truncatable 'false');
+  SELECT throws_matching(
+    'TRUNCATE fins_test',
+    'does not allow truncates',
+    'Check TRUNCATE of foreign table whose server disallows truncates'
+  );
+
+  -- TEST 4:
+  ALTER FOREIGN TABLE fins_test OPTIONS (ADD truncatable 'true');
+  SELECT lives_ok(
+    'TRUNCATE fins_test RESTART IDENTITY',
+    'Check TRUNCATE with table truncatable option overriding the server option'
+  );
+
+  -- TEST 5:
+  SELECT is(
+    (SELECT COUNT(*) FROM fins_test)::integer,
+    0,
+    'Verify remote table is truncated'
+  );
+
+  INSERT INTO fins_test (c1, c2) SELECT i, 'T' || i FROM generate_series(1, 5) i;
+
+  -- TEST 6:
+  SELECT throws_ok(
+    'TRUNCATE fins_test',
+    '25001',
+    NULL,
+    'Check TRUNCATE after a write in the same transaction is rejected'
+  );
+
+  -- Finish the tests and clean up.
+  SELECT * FROM finish();
+
+ROLLBACK;
@@ -0,0 +1,109 @@
+-- Start transaction and plan the tests.
+BEGIN;
+  CREATE EXTENSION IF NOT EXISTS pgtap;
+
+  SELECT plan(8);
+
+  CREATE EXTENSION IF NOT EXISTS tibero_fdw;
+
+  CREATE SERVER server_name FOREIGN DATA WRAPPER tibero_fdw
+    OPTIONS (host :'TIBERO_HOST', port :'TIBERO_PORT', dbname :'TIBERO_DB');
+
+  CREATE USER MAPPING FOR current_user
+    SERVER server_name
+    OPTIONS (username :'TIBERO_USER', password :'TIBERO_PASS');
+
+  CREATE FOREIGN TABLE fins_test (
+    c1 INT,
+    c2 VARCHAR(10),
+    c3 CHAR(9),
+    c4 BIGINT,
+    c5 DATE,
+    c6 DECIMAL(10,5),
+    c7 INT,
+    c8 SMALLINT,
+    c9 NCHAR(9),
+    c10 TEXT
+  ) server server_name options (owner_name :'TIBERO_USER', table_name 'ins_test', updatable 'on');
+
+  -- Verbose plan of a statement as one text, without running it
+  CREATE FUNCTION pg_temp.explain_verbose(query TEXT) RETURNS TEXT AS $$
+  DECLARE
+    line TEXT;
+    plan TEXT := '';
+  BEGIN
+    FOR line IN EXECUTE 'EXPLAIN (VERBOSE, COSTS OFF) ' || query LOOP
+      plan := plan || line || E'\n';
+    END LOOP;
+    RETURN plan;
+  END;
+  $$ LANGUAGE plpgsql;
+
+  INSERT INTO fins_test (c1, c2, c4)
+  SELECT i, 'U' || i, i * 10 FROM generate_series(1, 10) i;
+
+  -- TEST 1:
+  SELECT lives_ok('
+    UPDATE fins_test SET c2 = ''UPD'' || c1, c4 = NULL WHERE c1 <= 3;',
+    'Update rows of foreign table by ROWID'
+  );
+
+  -- TEST 2:
+  SELECT results_eq('
+    SELECT c1, c2, c4 FROM fins_test WHERE c1 <= 4 ORDER BY c1;',
+    $$VALUES (1, 'UPD1'::VARCHAR, NULL::BIGINT),
+             (2, 'UPD2'::VARCHAR, NULL::BIGINT),
+             (3, 'UPD3'::VARCHAR, NULL::BIGINT),
+             (4, 'U4'::VARCHAR, 40::BIGINT)$$,
+    'Verify only the changed columns of the matching rows are updated'
+  );
+
+  -- TEST 3:
+  SELECT lives_ok('
+    DELETE FROM fins_test WHERE c1 IN (4, 5);',
+    'Delete rows of foreign table by ROWID'
+  );
+
+  -- TEST 4:
+  SELECT is(
+    (SELECT COUNT(*) FROM fins_test WHERE c1 IN (4, 5))::integer,
+    0,
+    'Verify the matching rows are deleted'
+  );
+
+  ALTER FOREIGN TABLE fins_test OPTIONS (ADD batch_size '4');
+
+  -- An IN list is not shippable, so the rows below are modified by ROWID rather than by one
+  -- remote statement
+  -- TEST 5:
+  SELECT lives_ok('
+    UPDATE fins_test SET c4 = c1 * 100 WHERE c1 IN (6, 7, 8, 9, 10);',
+    'Update rows of foreign table in batches'
+  );
+
+  -- TEST 6:
+  SELECT results_eq('
+    SELECT c1, c4 FROM fins_test WHERE c1 > 5 ORDER BY c1;',
+    $$SELECT i, (i * 100)::BIGINT FROM generate_series(6, 10) i$$,
+    'Verify every row of a partially filled last batch is updated'
+  );
+
+  -- TEST 7:
+  DELETE FROM fins_test WHERE c1 IN (6, 7, 8, 9, 10);
+  SELECT is(
+    (SELECT COUNT(*) FROM fins_test)::integer,
+    3,
+    'Verify every row of a partially filled last batch is deleted'
+  );
+
+  -- TEST 8:
+  SELECT doesnt_match(
+    pg_temp.explain_verbose('DELETE FROM fins_test WHERE c1 IN (6, 7, 8, 9, 10)'),
+    'Remote SQL: DELETE',
+    'Verify DELETE with a non-shippable WHERE is not run as a single remote statement'
+  );
+
+  -- Finish the tests and clean up.
+  SELECT * FROM finish();
+
+ROLLBACK;
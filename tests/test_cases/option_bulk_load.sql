@@ -0,0 +1,122 @@
+-- Start transaction and plan the tests.
+BEGIN;
+  CREATE EXTENSION IF NOT EXISTS pgtap;
+
+  SELECT plan(8);
+
+  CREATE EXTENSION IF NOT EXISTS tibero_fdw;
+
+  CREATE SERVER server_name FOREIGN DATA WRAPPER tibero_fdw
+    OPTIONS (host :'TIBERO_HOST', port :'TIBERO_PORT', dbname :'TIBERO_DB', batch_size '100');
+
+  CREATE USER MAPPING FOR current_user
+    SERVER server_name
+    OPTIONS (username :'TIBERO_USER', password :'TIBERO_PASS');
+
+  -- The chunked load needs a connection that has not written in the transaction yet
+  CREATE SERVER server_bulk FOREIGN DATA WRAPPER tibero_fdw
+    OPTIONS (host :'TIBERO_HOST', port :'TIBERO_PORT', dbname :'TIBERO_DB', batch_size '100');
+
+  CREATE USER MAPPING FOR current_user
+    SERVER server_bulk
+    OPTIONS (username :'TIBERO_USER', password :'TIBERO_PASS');
+
+  -- A session of its own, which sees only the rows committed on Tibero
+  CREATE SERVER server_name2 FOREIGN DATA WRAPPER tibero_fdw
+    OPTIONS (host :'TIBERO_HOST', port :'TIBERO_PORT', dbname :'TIBERO_DB');
+
+  CREATE USER MAPPING FOR current_user
+    SERVER server_name2
+    OPTIONS (username :'TIBERO_USER', password :'TIBERO_PASS');
+
+  CREATE FOREIGN TABLE fins_test (
+    c1 INT,
+    c2 VARCHAR(10)
+  ) server server_name options (owner_name :'TIBERO_USER', table_name 'ins_test', updatable 'on');
+
+  -- TEST 1
+  SELECT throws_matching(
+    'ALTER FOREIGN TABLE fins_test OPTIONS (ADD bulk_load_commit_size ''-1'')',
+    'must be an integer value greater than zero',
+    'Check bulk_load_commit_size option rejects non-positive value'
+  );
+
+  -- TEST 2
+  SELECT throws_matching(
+    'ALTER SERVER server_name OPTIONS (ADD bulk_load ''true'')',
+    'invalid option "bulk_load"',
+    'Check bulk_load option is not a server option'
+  );
+
+  ALTER FOREIGN TABLE fins_test OPTIONS (ADD bulk_load 'true', ADD bulk_load_commit_size '250');
+
+  -- TEST 3
+  SELECT is(
+    (SELECT COUNT(*) FROM pg_catalog.pg_foreign_table
+      WHERE ftrelid = 'fins_test'::regclass
+        AND ftoptions @> array['bulk_load=true', 'bulk_load_commit_size=250'])::integer,
+    1,
+    'Check bulk_load options of ALTER FOREIGN TABLE command are saved on pg_foreign_table catalog'
+  );
+
+  -- Rows committed in chunks would survive the ROLLBACK below, so the load is kept in one chunk
+  ALTER FOREIGN TABLE fins_test OPTIONS (DROP bulk_load_commit_size);
+
+  -- TEST 4
+  SELECT lives_ok('
+    INSERT INTO fins_test SELECT i, ''BULK'' || i FROM generate_series(1, 1000) i',
+    'Check direct-path INSERT with array binding'
+  );
+
+  -- Chunks of 250 rows are committed as the 100-row batches reach them, at 300, 600 and 900 rows,
+  -- and bulk_load_test is loaded by this file only
+  CREATE FOREIGN TABLE fbulk_test (
+    c1 INT,
+    c2 VARCHAR(20)
+  ) server server_bulk options (owner_name :'TIBERO_USER', table_name 'bulk_load_test',
+                                updatable 'on', bulk_load 'true', bulk_load_commit_size '250');
+
+  CREATE FOREIGN TABLE fbulk_test_2 (
+    c1 INT,
+    c2 VARCHAR(20)
+  ) server server_name2 options (owner_name :'TIBERO_USER', table_name 'bulk_load_test');
+
+  -- TEST 5
+  SELECT lives_ok('
+    INSERT INTO fbulk_test SELECT i, ''BULK'' || i FROM generate_series(1, 1050) i',
+    'Check direct-path INSERT committed in chunks'
+  );
+
+  -- TEST 6
+  SELECT is(
+    (SELECT COUNT(*) FROM fbulk_test_2)::integer,
+    900,
+    'Verify full chunks are committed and the last partial chunk waits for the local transaction'
+  );
+
+  -- A chunk commit would also commit the rows written to fins_test above
+  CREATE FOREIGN TABLE fbulk_test_3 (
+    c1 INT,
+    c2 VARCHAR(20)
+  ) server server_name options (owner_name :'TIBERO_USER', table_name 'bulk_load_test',
+                                updatable 'on', bulk_load 'true', bulk_load_commit_size '250');
+
+  -- TEST 8
+  SELECT throws_ok(
+    'INSERT INTO fbulk_test_3 SELECT i, ''BULK'' || i FROM generate_series(1, 10) i',
+    '25001',
+    NULL,
+    'Check chunked load after writes in the same transaction is rejected'
+  );
+
+  -- TEST 7
+  SELECT throws_matching(
+    'ALTER FOREIGN TABLE fins_test OPTIONS (SET bulk_load '''')',
+    'requires non-empty value',
+    'Check bulk_load option rejects empty value'
+  );
+
+  -- Finish the tests and clean up.
+  SELECT * FROM finish();
+
+ROLLBACK;
@@ -0,0 +1,114 @@
+-- Start transaction and plan the tests.
+BEGIN;
+  CREATE EXTENSION IF NOT EXISTS pgtap;
+
+  SELECT plan(7);
+
+  CREATE EXTENSION IF NOT EXISTS tibero_fdw;
+
+  CREATE SERVER server_name FOREIGN DATA WRAPPER tibero_fdw
+    OPTIONS (host :'TIBERO_HOST', port :'TIBERO_PORT', dbname :'TIBERO_DB',
+             circuit_failures '3', circuit_cooldown '10');
+
+  CREATE USER MAPPING FOR current_user
+    SERVER server_name
+    OPTIONS (username :'TIBERO_USER', password :'TIBERO_PASS');
+
+  CREATE FOREIGN TABLE fst1 (
+    c1 INT,
+    c2 VARCHAR(10)
+  ) server server_name options (owner_name :'TIBERO_USER', table_name 'st1');
+
+  -- Nothing listens on port 1, so its connections always fail
+  CREATE SERVER server_down FOREIGN DATA WRAPPER tibero_fdw
+    OPTIONS (host '127.0.0.1', port '1', dbname :'TIBERO_DB', connect_timeout '1',
+             circuit_failures '1', circuit_cooldown '60');
+
+  CREATE USER MAPPING FOR current_user
+    SERVER server_down
+    OPTIONS (username :'TIBERO_USER', password :'TIBERO_PASS');
+
+  CREATE FOREIGN TABLE fst1_down (
+    c1 INT,
+    c2 VARCHAR(10)
+  ) server server_down options (owner_name :'TIBERO_USER', table_name 'st1');
+
+  CREATE SERVER server_auth FOREIGN DATA WRAPPER tibero_fdw
+    OPTIONS (host :'TIBERO_HOST', port :'TIBERO_PORT', dbname :'TIBERO_DB',
+             circuit_failures '1', circuit_cooldown '60');
+
+  CREATE USER MAPPING FOR current_user
+    SERVER server_auth
+    OPTIONS (username :'TIBERO_USER', password 'wrong password');
+
+  CREATE FOREIGN TABLE fst1_auth (
+    c1 INT,
+    c2 VARCHAR(10)
+  ) server server_auth options (owner_name :'TIBERO_USER', table_name 'st1');
+
+  -- Detail of the error the query raises
+  CREATE FUNCTION pg_temp.error_detail(query TEXT) RETURNS TEXT AS $$
+  DECLARE
+    detail TEXT;
+  BEGIN
+    EXECUTE query;
+    RETURN NULL;
+  EXCEPTION WHEN OTHERS THEN
+    GET STACKED DIAGNOSTICS detail = PG_EXCEPTION_DETAIL;
+    RETURN detail;
+  END;
+  $$ LANGUAGE plpgsql;
+
+  -- TEST 1
+  SELECT throws_matching(
+    'ALTER SERVER server_name OPTIONS (SET circuit_failures ''-1'')',
+    'must be an integer value greater than or equal to zero',
+    'Check circuit_failures option rejects negative value'
+  );
+
+  -- TEST 2
+  SELECT throws_matching(
+    'ALTER SERVER server_name OPTIONS (SET circuit_cooldown ''0'')',
+    'must be an integer value greater than zero',
+    'Check circuit_cooldown option rejects zero'
+  );
+
+  -- TEST 3
+  SELECT results_eq(
+    'SELECT c1 FROM fst1 WHERE c1 = 100',
+    $$VALUES (100)$$,
+    'Check SELECT on server with circuit breaker'
+  );
+
+  -- TEST 4
+  SELECT results_eq(
+    'SELECT c1 FROM fst1 WHERE c1 = 200',
+    $$VALUES (200)$$,
+    'Check SELECT after a successful connection'
+  );
+
+  -- TEST 5
+  SELECT throws_ok(
+    'SELECT c1 FROM fst1_down',
+    'Check unreachable server fails to connect'
+  );
+
+  -- TEST 6
+  SELECT matches(
+    pg_temp.error_detail('SELECT c1 FROM fst1_down'),
+    'failed in a row',
+    'Check connection fails fast once the circuit of the server is open'
+  );
+
+  -- TEST 7
+  SELECT doesnt_match(
+    pg_temp.error_detail('SELECT c1 FROM fst1_auth') || ' ' ||
+    pg_temp.error_detail('SELECT c1 FROM fst1_auth'),
+    'failed in a row',
+    'Check rejected logins do not open the circuit'
+  );
+
+  -- Finish the tests and clean up.
+  SELECT * FROM finish();
+
+ROLLBACK;
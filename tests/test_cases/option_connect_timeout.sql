@@ -0,0 +1,53 @@
+-- Start transaction and plan the tests.
+BEGIN;
+  CREATE EXTENSION IF NOT EXISTS pgtap;
+
+  SELECT plan(4);
+
+  CREATE EXTENSION IF NOT EXISTS tibero_fdw;
+
+  CREATE SERVER server_name FOREIGN DATA WRAPPER tibero_fdw
+    OPTIONS (host :'TIBERO_HOST', port :'TIBERO_PORT', dbname :'TIBERO_DB', connect_timeout '10');
+
+  CREATE USER MAPPING FOR current_user
+    SERVER server_name
+    OPTIONS (username :'TIBERO_USER', password :'TIBERO_PASS');
+
+  CREATE FOREIGN TABLE fst1 (
+    c1 INT,
+    c2 VARCHAR(10)
+  ) server server_name options (owner_name :'TIBERO_USER', table_name 'st1');
+
+  -- TEST 1
+  SELECT throws_matching(
+    'ALTER SERVER server_name OPTIONS (SET connect_timeout ''-1'')',
+    'must be an integer value greater than or equal to zero',
+    'Check connect_timeout option rejects negative value'
+  );
+
+  -- TEST 2
+  SELECT results_eq(
+    'SELECT c1 FROM fst1 WHERE c1 = 100',
+    $$VALUES (100)$$,
+    'Check SELECT on server with connect_timeout'
+  );
+
+  -- TEST 3
+  SELECT results_eq(
+    'SELECT count(*) FROM (SELECT c1 FROM fst1 LIMIT 1) s',
+    $$VALUES (1::BIGINT)$$,
+    'Check scan ended early cancels the remote query'
+  );
+
+  -- TEST 4
+  SET LOCAL statement_timeout = '30s';
+  SELECT results_eq(
+    'SELECT c1 FROM fst1 WHERE c1 = 100',
+    $$VALUES (100)$$,
+    'Check SELECT with statement_timeout passed as query timeout'
+  );
+
+  -- Finish the tests and clean up.
+  SELECT * FROM finish();
+
+ROLLBACK;
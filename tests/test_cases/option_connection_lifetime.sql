@@ -0,0 +1,62 @@
+-- Start transaction and plan the tests.
+BEGIN;
+  CREATE EXTENSION IF NOT EXISTS pgtap;
+
+  SELECT plan(5);
+
+  CREATE EXTENSION IF NOT EXISTS tibero_fdw;
+
+  CREATE SERVER server_name FOREIGN DATA WRAPPER tibero_fdw
+    OPTIONS (host :'TIBERO_HOST', port :'TIBERO_PORT', dbname :'TIBERO_DB',
+             idle_timeout '60', max_lifetime '3600');
+
+  CREATE USER MAPPING FOR current_user
+    SERVER server_name
+    OPTIONS (username :'TIBERO_USER', password :'TIBERO_PASS');
+
+  CREATE FOREIGN TABLE fst1 (
+    c1 INT,
+    c2 VARCHAR(10)
+  ) server server_name options (owner_name :'TIBERO_USER', table_name 'st1');
+
+  -- TEST 1
+  SELECT throws_matching(
+    'ALTER SERVER server_name OPTIONS (SET idle_timeout ''-1'')',
+    'must be an integer value greater than or equal to zero',
+    'Check idle_timeout option rejects negative value'
+  );
+
+  -- TEST 2
+  SELECT throws_matching(
+    'ALTER SERVER server_name OPTIONS (SET max_lifetime ''-1'')',
+    'must be an integer value greater than or equal to zero',
+    'Check max_lifetime option rejects negative value'
+  );
+
+  -- TEST 3
+  SELECT results_eq(
+    'SELECT c1 FROM fst1 WHERE c1 = 100',
+    $$VALUES (100)$$,
+    'Check SELECT on server with connection time limits'
+  );
+
+  -- The servers are connected to once, when the library is loaded at session start
+  -- TEST 4
+  SELECT is(
+    (SELECT context FROM pg_settings WHERE name = 'tibero_fdw.preconnect_servers'),
+    'backend',
+    'Check preconnect_servers parameter is fixed at session start'
+  );
+
+  -- TEST 5
+  SELECT throws_ok(
+    'SET LOCAL tibero_fdw.preconnect_servers = ''server_name''',
+    '55P02',
+    NULL,
+    'Check preconnect_servers parameter cannot be set in a session'
+  );
+
+  -- Finish the tests and clean up.
+  SELECT * FROM finish();
+
+ROLLBACK;
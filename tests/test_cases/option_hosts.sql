@@ -0,0 +1,72 @@
+-- Start transaction and plan the tests.
+BEGIN;
+  CREATE EXTENSION IF NOT EXISTS pgtap;
+
+  SELECT plan(6);
+
+  CREATE EXTENSION IF NOT EXISTS tibero_fdw;
+
+  -- The hosts listed after the primary one refuse connections, so each policy reaches the server
+  -- through failover
+  CREATE SERVER server_name FOREIGN DATA WRAPPER tibero_fdw
+    OPTIONS (host :'TIBERO_HOST', port :'TIBERO_PORT', dbname :'TIBERO_DB',
+             hosts '127.0.0.1:1', host_policy 'failover', connect_timeout '5');
+
+  CREATE USER MAPPING FOR current_user
+    SERVER server_name
+    OPTIONS (username :'TIBERO_USER', password :'TIBERO_PASS');
+
+  CREATE FOREIGN TABLE fst1 (
+    c1 INT,
+    c2 VARCHAR(10)
+  ) server server_name options (owner_name :'TIBERO_USER', table_name 'st1');
+
+  -- TEST 1
+  SELECT throws_matching(
+    'ALTER SERVER server_name OPTIONS (SET hosts ''host1:port'')',
+    'invalid value for option "hosts"',
+    'Check hosts option rejects a malformed port'
+  );
+
+  -- TEST 2
+  SELECT throws_matching(
+    'ALTER SERVER server_name OPTIONS (SET host_policy ''random'')',
+    'invalid value for option "host_policy"',
+    'Check host_policy option rejects an unknown policy'
+  );
+
+  -- TEST 3
+  SELECT results_eq(
+    'SELECT c1 FROM fst1 WHERE c1 = 100',
+    $$VALUES (100)$$,
+    'Check SELECT connects to the first host in failover order'
+  );
+
+  -- TEST 4
+  ALTER SERVER server_name OPTIONS (SET host_policy 'round_robin');
+  SELECT results_eq(
+    'SELECT c1 FROM fst1 WHERE c1 = 100',
+    $$VALUES (100)$$,
+    'Check SELECT fails over from an unreachable host in round robin'
+  );
+
+  -- TEST 5
+  ALTER SERVER server_name OPTIONS (SET host_policy 'least_connections');
+  SELECT results_eq(
+    'SELECT c1 FROM fst1 WHERE c1 = 100',
+    $$VALUES (100)$$,
+    'Check SELECT with least connections policy'
+  );
+
+  -- TEST 6
+  ALTER SERVER server_name OPTIONS (ADD standby_hosts '127.0.0.1:1');
+  SELECT results_eq(
+    'SELECT c1 FROM fst1 WHERE c1 = 100',
+    $$VALUES (100)$$,
+    'Check SELECT leaves standby hosts out of a transaction that may write'
+  );
+
+  -- Finish the tests and clean up.
+  SELECT * FROM finish();
+
+ROLLBACK;
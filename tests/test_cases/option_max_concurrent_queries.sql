@@ -0,0 +1,80 @@
+-- Start transaction and plan the tests.
+BEGIN;
+  CREATE EXTENSION IF NOT EXISTS pgtap;
+
+  SELECT plan(7);
+
+  CREATE EXTENSION IF NOT EXISTS tibero_fdw;
+
+  CREATE SERVER server_name FOREIGN DATA WRAPPER tibero_fdw
+    OPTIONS (host :'TIBERO_HOST', port :'TIBERO_PORT', dbname :'TIBERO_DB',
+             max_concurrent_queries '1', queue_timeout '1000');
+
+  CREATE USER MAPPING FOR current_user
+    SERVER server_name
+    OPTIONS (username :'TIBERO_USER', password :'TIBERO_PASS');
+
+  CREATE FOREIGN TABLE fst1 (
+    c1 INT,
+    c2 VARCHAR(10)
+  ) server server_name options (owner_name :'TIBERO_USER', table_name 'st1');
+
+  -- TEST 1
+  SELECT throws_matching(
+    'ALTER SERVER server_name OPTIONS (SET max_concurrent_queries ''-1'')',
+    'must be an integer value greater than or equal to zero',
+    'Check max_concurrent_queries option rejects negative value'
+  );
+
+  -- TEST 2
+  SELECT throws_matching(
+    'ALTER SERVER server_name OPTIONS (SET queue_timeout ''0'')',
+    'must be an integer value greater than zero',
+    'Check queue_timeout option rejects an unbounded wait'
+  );
+
+  -- TEST 3
+  SELECT results_eq(
+    'SELECT c1 FROM fst1 WHERE c1 = 100',
+    $$VALUES (100)$$,
+    'Check SELECT takes the query slot of the server'
+  );
+
+  -- TEST 4
+  SELECT results_eq(
+    'SELECT a.c1, b.c1 FROM fst1 a, fst1 b WHERE a.c1 = 100 AND b.c1 = 200',
+    $$VALUES (100, 200)$$,
+    'Check scans of one query share the query slot of the server'
+  );
+
+  -- TEST 5
+  SELECT results_eq(
+    'SELECT c1 FROM fst1 WHERE c1 = 100',
+    $$VALUES (100)$$,
+    'Check query slot is given back after the query'
+  );
+
+  -- A cursor keeps the query slot until it is closed
+  DECLARE c1 CURSOR FOR SELECT c1 FROM fst1 ORDER BY c1;
+  FETCH c1;
+
+  -- TEST 6
+  SELECT results_eq(
+    'SELECT c1 FROM fst1 WHERE c1 = 200',
+    $$VALUES (200)$$,
+    'Check statement of the backend holding the slot in a cursor does not wait for itself'
+  );
+
+  CLOSE c1;
+
+  -- TEST 7
+  SELECT results_eq(
+    'SELECT c1 FROM fst1 WHERE c1 = 100',
+    $$VALUES (100)$$,
+    'Check query slot is given back when the cursor is closed'
+  );
+
+  -- Finish the tests and clean up.
+  SELECT * FROM finish();
+
+ROLLBACK;
@@ -0,0 +1,60 @@
+-- Start transaction and plan the tests.
+BEGIN;
+  CREATE EXTENSION IF NOT EXISTS pgtap;
+
+  SELECT plan(5);
+
+  CREATE EXTENSION IF NOT EXISTS tibero_fdw;
+
+  CREATE SERVER server_name FOREIGN DATA WRAPPER tibero_fdw
+    OPTIONS (host :'TIBERO_HOST', port :'TIBERO_PORT', dbname :'TIBERO_DB', stmt_cache_size '1');
+
+  CREATE USER MAPPING FOR current_user
+    SERVER server_name
+    OPTIONS (username :'TIBERO_USER', password :'TIBERO_PASS');
+
+  CREATE FOREIGN TABLE fst1 (
+    c1 INT,
+    c2 VARCHAR(10)
+  ) server server_name options (owner_name :'TIBERO_USER', table_name 'st1');
+
+  -- TEST 1
+  SELECT throws_matching(
+    'ALTER SERVER server_name OPTIONS (SET stmt_cache_size ''-1'')',
+    'must be an integer value greater than or equal to zero',
+    'Check stmt_cache_size option rejects negative value'
+  );
+
+  -- TEST 2
+  SELECT results_eq(
+    'SELECT c1 FROM fst1 WHERE c1 = 100',
+    $$VALUES (100)$$,
+    'Check SELECT prepares a statement for the cache'
+  );
+
+  -- TEST 3
+  SELECT results_eq(
+    'SELECT c1 FROM fst1 WHERE c1 = 100',
+    $$VALUES (100)$$,
+    'Check SELECT reuses the cached statement'
+  );
+
+  -- TEST 4
+  SELECT results_eq(
+    'SELECT a.c1, b.c1 FROM fst1 a, fst1 b WHERE a.c1 = 100 AND b.c1 = 200',
+    $$VALUES (100, 200)$$,
+    'Check statements in use at the same time beyond the cache size'
+  );
+
+  -- TEST 5
+  ALTER SERVER server_name OPTIONS (SET stmt_cache_size '0');
+  SELECT results_eq(
+    'SELECT c1 FROM fst1 WHERE c1 = 100',
+    $$VALUES (100)$$,
+    'Check SELECT with statement cache disabled'
+  );
+
+  -- Finish the tests and clean up.
+  SELECT * FROM finish();
+
+ROLLBACK;
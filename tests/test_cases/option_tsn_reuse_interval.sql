@@ -0,0 +1,65 @@
+-- Start transaction and plan the tests.
+BEGIN;
+  CREATE EXTENSION IF NOT EXISTS pgtap;
+
+  SELECT plan(4);
+
+  CREATE EXTENSION IF NOT EXISTS tibero_fdw;
+
+  CREATE SERVER server_name FOREIGN DATA WRAPPER tibero_fdw
+    OPTIONS (host :'TIBERO_HOST', port :'TIBERO_PORT', dbname :'TIBERO_DB',
+             use_fb_query 'true', tsn_reuse_interval '60000');
+
+  CREATE SERVER server_name2 FOREIGN DATA WRAPPER tibero_fdw
+    OPTIONS (host :'TIBERO_HOST', port :'TIBERO_PORT', dbname :'TIBERO_DB', use_fb_query 'true');
+
+  CREATE USER MAPPING FOR current_user
+    SERVER server_name
+    OPTIONS (username :'TIBERO_USER', password :'TIBERO_PASS');
+
+  CREATE USER MAPPING FOR current_user
+    SERVER server_name2
+    OPTIONS (username :'TIBERO_USER', password :'TIBERO_PASS');
+
+  CREATE FOREIGN TABLE fst1 (
+    c1 INT,
+    c2 VARCHAR(10)
+  ) server server_name options (owner_name :'TIBERO_USER', table_name 'st1');
+
+  CREATE FOREIGN TABLE fst1_2 (
+    c1 INT,
+    c2 VARCHAR(10)
+  ) server server_name2 options (owner_name :'TIBERO_USER', table_name 'st1');
+
+  -- TEST 1
+  SELECT throws_matching(
+    'ALTER SERVER server_name OPTIONS (SET tsn_reuse_interval ''-1'')',
+    'must be an integer value greater than or equal to zero',
+    'Check tsn_reuse_interval option rejects negative value'
+  );
+
+  -- TEST 2
+  SELECT results_eq(
+    'SELECT c1 FROM fst1 WHERE c1 = 100',
+    $$VALUES (100)$$,
+    'Check flashback query takes a TSN'
+  );
+
+  -- TEST 3
+  SELECT results_eq(
+    'SELECT c1 FROM fst1 WHERE c1 = 100',
+    $$VALUES (100)$$,
+    'Check flashback query reuses the TSN within the interval'
+  );
+
+  -- TEST 4
+  SELECT results_eq(
+    'SELECT a.c1, b.c1 FROM fst1 a, fst1_2 b WHERE a.c1 = 100 AND b.c1 = 200',
+    $$VALUES (100, 200)$$,
+    'Check flashback queries on several servers in one statement'
+  );
+
+  -- Finish the tests and clean up.
+  SELECT * FROM finish();
+
+ROLLBACK;
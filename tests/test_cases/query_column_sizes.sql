@@ -0,0 +1,86 @@
+-- Start transaction and plan the tests.
+BEGIN;
+  CREATE EXTENSION IF NOT EXISTS pgtap;
+
+  SELECT plan(6);
+
+  CREATE EXTENSION IF NOT EXISTS tibero_fdw;
+
+  CREATE SERVER server_name FOREIGN DATA WRAPPER tibero_fdw
+    OPTIONS (host :'TIBERO_HOST', port :'TIBERO_PORT', dbname :'TIBERO_DB');
+
+  CREATE USER MAPPING FOR current_user
+    SERVER server_name
+    OPTIONS (username :'TIBERO_USER', password :'TIBERO_PASS');
+
+  CREATE FOREIGN TABLE fst1 (
+      c1 INT,
+      c2 VARCHAR(10),
+      c3 CHAR(9),
+      c4 BIGINT,
+      c5 DATE,
+      c6 DECIMAL(10,5),
+      c7 INT,
+      c8 SMALLINT,
+      c9 NCHAR(9),
+      c10 TEXT
+  ) SERVER server_name OPTIONS (owner_name :'TIBERO_USER', table_name 'st1');
+
+  -- TEST 1:
+  SELECT results_eq('
+    SELECT c1, c2, c10 FROM fst1 WHERE c1 = 1400',
+    $$VALUES (1400::INT, 'HS14'::VARCHAR, '가가가가가가가가가가가가가가'::TEXT)$$,
+    'Check first scan describes the result columns'
+  );
+
+  -- TEST 2:
+  SELECT results_eq('
+    SELECT c1, c2, c10 FROM fst1 WHERE c1 = 1400',
+    $$VALUES (1400::INT, 'HS14'::VARCHAR, '가가가가가가가가가가가가가가'::TEXT)$$,
+    'Check scan planned with the remembered column sizes'
+  );
+
+  -- TEST 3:
+  SELECT results_eq('
+    SELECT c10, c1 FROM fst1 WHERE c1 = 1400',
+    $$VALUES ('가가가가가가가가가가가가가가'::TEXT, 1400::INT)$$,
+    'Check scan retrieving the remembered columns in another order'
+  );
+
+  -- TEST 4:
+  ALTER FOREIGN TABLE fst1 ALTER COLUMN c2 TYPE VARCHAR(20);
+  SELECT results_eq('
+    SELECT c1, c2, c10 FROM fst1 WHERE c1 = 1400',
+    $$VALUES (1400::INT, 'HS14'::VARCHAR, '가가가가가가가가가가가가가가'::TEXT)$$,
+    'Check scan after the foreign table definition changed'
+  );
+
+  -- A mapping of another user may lead to another remote table, so its sizes are kept apart
+  CREATE USER MAPPING FOR PUBLIC
+    SERVER server_name
+    OPTIONS (username :'TIBERO_USER', password :'TIBERO_PASS');
+  CREATE ROLE tbfdw_sizes_role;
+  GRANT SELECT ON fst1 TO tbfdw_sizes_role;
+  PREPARE sizes_query AS SELECT c1, c2 FROM fst1 WHERE c1 = 1400;
+
+  -- TEST 5:
+  SET LOCAL ROLE tbfdw_sizes_role;
+  SELECT results_eq(
+    'sizes_query',
+    $$VALUES (1400::INT, 'HS14'::VARCHAR)$$,
+    'Check scan planned by another user'
+  );
+  RESET ROLE;
+
+  -- TEST 6:
+  SELECT results_eq(
+    'sizes_query',
+    $$VALUES (1400::INT, 'HS14'::VARCHAR)$$,
+    'Check scan run by a user other than the one it was planned by'
+  );
+  DEALLOCATE sizes_query;
+
+  -- Finish the tests and clean up.
+  SELECT * FROM finish();
+
+ROLLBACK;
@@ -0,0 +1,76 @@
+-- Start transaction and plan the tests.
+BEGIN;
+  CREATE EXTENSION IF NOT EXISTS pgtap;
+
+  SELECT plan(4);
+
+  CREATE EXTENSION IF NOT EXISTS tibero_fdw;
+
+  CREATE SERVER server_name FOREIGN DATA WRAPPER tibero_fdw
+    OPTIONS (host :'TIBERO_HOST', port :'TIBERO_PORT', dbname :'TIBERO_DB');
+
+  CREATE SERVER server_name2 FOREIGN DATA WRAPPER tibero_fdw
+    OPTIONS (host :'TIBERO_HOST', port :'TIBERO_PORT', dbname :'TIBERO_DB', use_fb_query 'true');
+
+  -- Nothing listens on port 1, so its connection always fails
+  CREATE SERVER server_down FOREIGN DATA WRAPPER tibero_fdw
+    OPTIONS (host '127.0.0.1', port '1', dbname :'TIBERO_DB', connect_timeout '1');
+
+  CREATE USER MAPPING FOR current_user
+    SERVER server_name
+    OPTIONS (username :'TIBERO_USER', password :'TIBERO_PASS');
+
+  CREATE USER MAPPING FOR current_user
+    SERVER server_name2
+    OPTIONS (username :'TIBERO_USER', password :'TIBERO_PASS');
+
+  CREATE USER MAPPING FOR current_user
+    SERVER server_down
+    OPTIONS (username :'TIBERO_USER', password :'TIBERO_PASS');
+
+  CREATE FOREIGN TABLE fst1 (
+    c1 INT,
+    c2 VARCHAR(10)
+  ) SERVER server_name OPTIONS (owner_name :'TIBERO_USER', table_name 'st1');
+
+  CREATE FOREIGN TABLE fst1_2 (
+    c1 INT,
+    c2 VARCHAR(10)
+  ) SERVER server_name2 OPTIONS (owner_name :'TIBERO_USER', table_name 'st1');
+
+  CREATE FOREIGN TABLE fst1_down (
+    c1 INT,
+    c2 VARCHAR(10)
+  ) SERVER server_down OPTIONS (owner_name :'TIBERO_USER', table_name 'st1');
+
+  -- TEST 1
+  SELECT results_eq(
+    'SELECT a.c1, b.c1 FROM fst1 a, fst1_2 b WHERE a.c1 = 100 AND b.c1 = 200',
+    $$VALUES (100, 200)$$,
+    'Check query connecting to several servers at once'
+  );
+
+  -- TEST 2
+  SELECT results_eq(
+    'SELECT a.c1, b.c1 FROM fst1 a, fst1_2 b WHERE a.c1 = 200 AND b.c1 = 100',
+    $$VALUES (200, 100)$$,
+    'Check query on the connections already made'
+  );
+
+  -- TEST 3
+  SELECT throws_ok(
+    'SELECT a.c1, b.c1 FROM fst1_2 a, fst1_down b WHERE a.c1 = 100',
+    'Check failed connection is reported by its scan'
+  );
+
+  -- TEST 4
+  SELECT results_eq(
+    'SELECT c1 FROM fst1_2 WHERE c1 = 100',
+    $$VALUES (100)$$,
+    'Check server connected along with a failed one is usable'
+  );
+
+  -- Finish the tests and clean up.
+  SELECT * FROM finish();
+
+ROLLBACK;
@@ -0,0 +1,63 @@
+-- Start transaction and plan the tests.
+BEGIN;
+  CREATE EXTENSION IF NOT EXISTS pgtap;
+
+  SELECT plan(5);
+
+  CREATE EXTENSION IF NOT EXISTS tibero_fdw;
+
+  CREATE SERVER server_name FOREIGN DATA WRAPPER tibero_fdw
+    OPTIONS (host :'TIBERO_HOST', port :'TIBERO_PORT', dbname :'TIBERO_DB');
+
+  CREATE USER MAPPING FOR current_user
+    SERVER server_name
+    OPTIONS (username :'TIBERO_USER', password :'TIBERO_PASS');
+
+  CREATE FOREIGN TABLE fst1 (
+    c1 INT,
+    c2 VARCHAR(10)
+  ) server server_name options (owner_name :'TIBERO_USER', table_name 'st1');
+
+  -- TEST 1
+  SELECT results_eq(
+    'SELECT c1 FROM fst1 WHERE c1 = 100',
+    $$VALUES (100)$$,
+    'Check SELECT counts its session against the server'
+  );
+
+  -- TEST 2
+  SELECT throws_ok(
+    'SET tibero_fdw.max_sessions_per_server = 1',
+    '55P02',
+    NULL,
+    'Check max_sessions_per_server is set only in the server configuration'
+  );
+
+  -- TEST 3
+  SELECT results_eq(
+    'SELECT a.c1, b.c1 FROM fst1 a, fst1 b WHERE a.c1 = 100 AND b.c1 = 200',
+    $$VALUES (100, 200)$$,
+    'Check scans sharing the session of the server'
+  );
+
+  -- TEST 4
+  SELECT throws_ok(
+    'SET LOCAL tibero_fdw.session_wait_timeout = -1',
+    '22023',
+    NULL,
+    'Check session_wait_timeout rejects negative value'
+  );
+
+  SET LOCAL tibero_fdw.session_wait_timeout = '5s';
+
+  -- TEST 5
+  SELECT is(
+    current_setting('tibero_fdw.session_wait_timeout'),
+    '5s',
+    'Check session_wait_timeout is set in milliseconds by the session'
+  );
+
+  -- Finish the tests and clean up.
+  SELECT * FROM finish();
+
+ROLLBACK;
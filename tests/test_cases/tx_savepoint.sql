@@ -0,0 +1,78 @@
+-- Start transaction and plan the tests.
+BEGIN;
+  CREATE EXTENSION IF NOT EXISTS pgtap;
+
+  SELECT plan(5);
+
+  CREATE EXTENSION IF NOT EXISTS tibero_fdw;
+
+  CREATE SERVER server_name FOREIGN DATA WRAPPER tibero_fdw
+    OPTIONS (host :'TIBERO_HOST', port :'TIBERO_PORT', dbname :'TIBERO_DB');
+
+  CREATE USER MAPPING FOR current_user
+    SERVER server_name
+    OPTIONS (username :'TIBERO_USER', password :'TIBERO_PASS');
+
+  CREATE FOREIGN TABLE fins_test (
+    c1 INT,
+    c2 VARCHAR(10)
+  ) SERVER server_name OPTIONS (owner_name :'TIBERO_USER', table_name 'ins_test', updatable 'on');
+
+  INSERT INTO fins_test (c1, c2) VALUES (1, 'TOP');
+
+  SAVEPOINT sp1;
+  INSERT INTO fins_test (c1, c2) VALUES (2, 'ROLLED');
+  ROLLBACK TO SAVEPOINT sp1;
+
+  -- TEST 1
+  SELECT results_eq(
+    'SELECT c1 FROM fins_test ORDER BY c1',
+    $$VALUES (1)$$,
+    'Check ROLLBACK TO SAVEPOINT rolls back the remote write'
+  );
+
+  SAVEPOINT sp2;
+  INSERT INTO fins_test (c1, c2) VALUES (3, 'RELEASED');
+  RELEASE SAVEPOINT sp2;
+
+  -- TEST 2
+  SELECT results_eq(
+    'SELECT c1 FROM fins_test ORDER BY c1',
+    $$VALUES (1), (3)$$,
+    'Check released savepoint keeps the remote write'
+  );
+
+  DO $$
+  BEGIN
+    INSERT INTO fins_test (c1, c2) VALUES (4, 'BLOCK');
+    RAISE EXCEPTION 'abort the block';
+  EXCEPTION WHEN OTHERS THEN
+    NULL;
+  END;
+  $$;
+
+  -- TEST 3
+  SELECT results_eq(
+    'SELECT c1 FROM fins_test ORDER BY c1',
+    $$VALUES (1), (3)$$,
+    'Check exception block rolls back the remote write'
+  );
+
+  -- c2 is VARCHAR(10) on Tibero, so the second row of the statement is rejected
+  -- TEST 4
+  SELECT throws_ok(
+    'INSERT INTO fins_test (c1, c2) VALUES (5, ''FITS''), (6, ''TOO LONG FOR COLUMN'')',
+    'Check failing INSERT within a subtransaction'
+  );
+
+  -- TEST 5
+  SELECT results_eq(
+    'SELECT c1 FROM fins_test ORDER BY c1',
+    $$VALUES (1), (3)$$,
+    'Verify rows of the failed statement are rolled back with its subtransaction'
+  );
+
+  -- Finish the tests and clean up.
+  SELECT * FROM finish();
+
+ROLLBACK;
@@ -0,0 +1,49 @@
+-- Start transaction and plan the tests.
+BEGIN ISOLATION LEVEL SERIALIZABLE;
+  CREATE EXTENSION IF NOT EXISTS pgtap;
+
+  SELECT plan(3);
+
+  CREATE EXTENSION IF NOT EXISTS tibero_fdw;
+
+  CREATE SERVER server_name FOREIGN DATA WRAPPER tibero_fdw
+    OPTIONS (host :'TIBERO_HOST', port :'TIBERO_PORT', dbname :'TIBERO_DB');
+
+  CREATE USER MAPPING FOR current_user
+    SERVER server_name
+    OPTIONS (username :'TIBERO_USER', password :'TIBERO_PASS');
+
+  CREATE FOREIGN TABLE fst1 (
+    c1 INT,
+    c2 VARCHAR(10)
+  ) SERVER server_name OPTIONS (owner_name :'TIBERO_USER', table_name 'st1');
+
+  CREATE FOREIGN TABLE fins_test (
+    c1 INT,
+    c2 VARCHAR(10)
+  ) SERVER server_name OPTIONS (owner_name :'TIBERO_USER', table_name 'ins_test', updatable 'on');
+
+  -- TEST 1
+  SELECT results_eq(
+    'SELECT c1 FROM fst1 WHERE c1 = 100',
+    $$VALUES (100)$$,
+    'Check SELECT within serializable transaction'
+  );
+
+  -- TEST 2
+  SELECT lives_ok(
+    'INSERT INTO fins_test (c1, c2) VALUES (1, ''S1'')',
+    'Check INSERT within serializable transaction'
+  );
+
+  -- TEST 3
+  SELECT results_eq(
+    'SELECT c2 FROM fins_test WHERE c1 = 1',
+    $$VALUES ('S1'::VARCHAR)$$,
+    'Verify serializable transaction sees its own write'
+  );
+
+  -- Finish the tests and clean up.
+  SELECT * FROM finish();
+
+ROLLBACK;
@@ -0,0 +1,55 @@
+-- Start transaction and plan the tests.
+BEGIN;
+  CREATE EXTENSION IF NOT EXISTS pgtap;
+
+  SELECT plan(3);
+
+  CREATE EXTENSION IF NOT EXISTS tibero_fdw;
+
+  CREATE SERVER server_name FOREIGN DATA WRAPPER tibero_fdw
+    OPTIONS (host :'TIBERO_HOST', port :'TIBERO_PORT', dbname :'TIBERO_DB');
+
+  -- Both mappings log in as the same Tibero user, so they share one connection
+  CREATE USER MAPPING FOR current_user
+    SERVER server_name
+    OPTIONS (username :'TIBERO_USER', password :'TIBERO_PASS');
+
+  CREATE USER MAPPING FOR PUBLIC
+    SERVER server_name
+    OPTIONS (username :'TIBERO_USER', password :'TIBERO_PASS');
+
+  CREATE ROLE tbfdw_shared_role;
+
+  CREATE FOREIGN TABLE fins_test (
+    c1 INT,
+    c2 VARCHAR(10)
+  ) SERVER server_name OPTIONS (owner_name :'TIBERO_USER', table_name 'ins_test', updatable 'on');
+
+  GRANT SELECT ON fins_test TO tbfdw_shared_role;
+
+  -- TEST 1
+  SELECT lives_ok(
+    'INSERT INTO fins_test (c1, c2) VALUES (1, ''SHARED'')',
+    'Check INSERT through the mapping of the current user'
+  );
+
+  -- TEST 2
+  SET LOCAL ROLE tbfdw_shared_role;
+  SELECT results_eq(
+    'SELECT c2 FROM fins_test WHERE c1 = 1',
+    $$VALUES ('SHARED'::VARCHAR)$$,
+    'Verify PUBLIC mapping with the same credentials sees the uncommitted row'
+  );
+  RESET ROLE;
+
+  -- TEST 3
+  SELECT results_eq(
+    'SELECT c2 FROM fins_test WHERE c1 = 1',
+    $$VALUES ('SHARED'::VARCHAR)$$,
+    'Check current user goes on with the shared connection'
+  );
+
+  -- Finish the tests and clean up.
+  SELECT * FROM finish();
+
+ROLLBACK;
@@ -0,0 +1,44 @@
+-- Start transaction and plan the tests.
+BEGIN;
+  CREATE EXTENSION IF NOT EXISTS pgtap;
+
+  SELECT plan(3);
+
+  CREATE EXTENSION IF NOT EXISTS tibero_fdw;
+
+  CREATE SERVER server_name FOREIGN DATA WRAPPER tibero_fdw
+    OPTIONS (host :'TIBERO_HOST', port :'TIBERO_PORT', dbname :'TIBERO_DB');
+
+  CREATE USER MAPPING FOR current_user
+    SERVER server_name
+    OPTIONS (username :'TIBERO_USER', password :'TIBERO_PASS');
+
+  -- c2 is VARCHAR(10) on Tibero, so a longer value is rejected by the remote statement
+  CREATE FOREIGN TABLE fins_test (
+    c1 INT,
+    c2 TEXT
+  ) SERVER server_name OPTIONS (owner_name :'TIBERO_USER', table_name 'ins_test', updatable 'on');
+
+  -- TEST 1
+  SELECT throws_ok(
+    'INSERT INTO fins_test (c1, c2) VALUES (1, ''TOO LONG FOR COLUMN'')',
+    'Check remote statement error is reported'
+  );
+
+  -- TEST 2
+  SELECT lives_ok(
+    'INSERT INTO fins_test (c1, c2) VALUES (2, ''FITS'')',
+    'Check connection is usable after a remote statement error'
+  );
+
+  -- TEST 3
+  SELECT results_eq(
+    'SELECT c1, c2 FROM fins_test',
+    $$VALUES (2, 'FITS'::TEXT)$$,
+    'Verify only the statement without error wrote'
+  );
+
+  -- Finish the tests and clean up.
+  SELECT * FROM finish();
+
+ROLLBACK;
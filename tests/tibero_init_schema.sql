@@ -350,4 +350,10 @@ BEGIN
                 )';
   EXECUTE IMMEDIATE ddl_query;
 
+  ddl_query := 'CREATE TABLE bulk_load_test (
+                c1 INTEGER,
+                c2 VARCHAR(20)
+                )';
+  EXECUTE IMMEDIATE ddl_query;
+
 END;
@@ -180,4 +180,11 @@ BEGIN
 			WHEN OTHERS THEN
 				NULL;
 	END;
+
+	BEGIN
+		EXECUTE IMMEDIATE 'DROP TABLE BULK_LOAD_TEST';
+		EXCEPTION
+			WHEN OTHERS THEN
+				NULL;
+	END;
 END;
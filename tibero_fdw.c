@@ -20,6 +20,7 @@
 #include "access/xact.h"													/* IsolationUsesXactSnapshot										*/
 #include "catalog/pg_class.h"
 #include "catalog/pg_opfamily.h"
+#include "catalog/pg_type.h"
 #include "commands/defrem.h"
 #if PG_VERSION_NUM >= 180000
 #include "commands/explain_state.h"
@@ -27,15 +28,21 @@
 #endif
 #include "commands/explain.h"
 #include "commands/vacuum.h"
+#include "datatype/timestamp.h"										/* MAX_TIMESTAMP_PRECISION											*/
 #include "executor/execAsync.h"
+#include "executor/instrument.h"
 #include "foreign/fdwapi.h"
 #include "funcapi.h"
+#include "mb/pg_wchar.h"													/* pg_database_encoding_max_length							*/
 #include "miscadmin.h"
 #include "nodes/makefuncs.h"
 #include "nodes/nodeFuncs.h"
 #include "optimizer/appendinfo.h"
 #include "optimizer/clauses.h"
 #include "optimizer/cost.h"
+#if PG_VERSION_NUM >= 160000
+#include "optimizer/inherit.h"										/* get_rel_all_updated_cols											*/
+#endif
 #include "optimizer/optimizer.h"
 #include "optimizer/pathnode.h"
 #include "optimizer/paths.h"
@@ -44,25 +51,31 @@
 #include "optimizer/restrictinfo.h"
 #include "optimizer/tlist.h"
 #include "parser/parsetree.h"
-#if PG_VERSION_NUM < 160000
 #include "parser/parse_relation.h"
-#endif
 #include "storage/latch.h"
 #include "utils/builtins.h"
+#include "utils/date.h"
+#include "utils/datetime.h"												/* MAXDATELEN																		*/
 #include "utils/float.h"
 #include "utils/guc.h"
+#include "utils/hsearch.h"
+#include "utils/inval.h"													/* CacheRegisterRelcacheCallback								*/
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
 #include "utils/rel.h"
 #include "utils/sampling.h"
 #include "utils/selfuncs.h"
 #include "utils/syscache.h"												/* TYPEOID																			*/
+#include "utils/timestamp.h"
 
 #include "tibero_fdw.h"
 #include "connection.h"
 
 /* {{{ global variables ***************************************************************************/
 extern bool is_signal_handlers_registered;
+
+/* Servers connected to when the library is loaded at session start */
+static char *preconnect_servers = NULL;
 /*************************************************************************** global variables }}} */
 
 PG_MODULE_MAGIC;
@@ -70,8 +83,12 @@ PG_MODULE_MAGIC;
 #define DEFAULT_FDW_STARTUP_COST	100.0
 #define DEFAULT_FDW_TUPLE_COST		0.01
 #define DEFAULT_FDW_FETCH_SIZE		100
+#define DEFAULT_FDW_BATCH_SIZE		1
+#define DEFAULT_FDW_PARAM_WIDTH		256
 #define TB_MAXLEN_SQLID_WITH_NULL 129
 #define TB_FDW_INIT_TUPLE_CNT			-1
+#define TB_FDW_IMPORT_FETCH_SIZE	1000
+#define TB_MAXLEN_TYPENAME_WITH_NULL 129
 
 enum FdwScanPrivateIndex
 {
@@ -79,6 +96,8 @@ enum FdwScanPrivateIndex
 	FdwScanPrivateRetrievedAttrs,
 	FdwScanPrivateFetchSize,
 	FdwScanPrivateUseFbQuery,
+	FdwScanPrivateColumnSizes,
+	FdwScanPrivateColumnSizesUser,
 	FdwScanPrivateRelations
 };
 
@@ -94,6 +113,12 @@ enum FdwModifyPrivateIndex
 	TbFdwModifyTargetAttrs
 };
 
+enum FdwDirectModifyPrivateIndex
+{
+	TbFdwDirectModifyQuery,
+	TbFdwDirectModifySetProcessed
+};
+
 typedef struct TbColumn
 {
 	SQLCHAR col_name[TB_MAXLEN_SQLID_WITH_NULL];
@@ -133,20 +158,103 @@ typedef struct TbFdwScanState
 	TbTable *table;
 
 	bool use_fb_query;
+
+	/* Scan tuple laid out by fdw_scan_tlist, and position of its whole-row column or -1 */
+	bool has_scan_tlist;
+	int wholerow_pos;
+
+	/* Buffer sizes known at plan time, and whether the buffers were bound with them */
+	List *column_sizes;
+	bool sizes_from_plan;
+	bool first_fetch;
+
+	/* User the foreign table is scanned as, which picks the user mapping */
+	Oid userid;
 } TbFdwScanState;
 
+/*
+ * Result buffer sizes of the columns of a foreign table, remembered from the first scan that
+ * described them. Scans planned afterwards bind their buffers with these sizes and skip describing
+ * the result. The user mapping may point the table at another remote table, so the sizes are kept
+ * per user. Entries are dropped when the foreign table, its server or a user mapping changes.
+ */
+typedef struct TbColumnSizeKey
+{
+	Oid relid;
+	Oid userid;
+} TbColumnSizeKey;
+
+typedef struct TbColumnSizeEntry
+{
+	TbColumnSizeKey key;				/* hash key */
+	int natts;
+	SQLUINTEGER *col_sizes;			/* indexed by attnum - 1, zero if not described yet */
+} TbColumnSizeEntry;
+
+static HTAB *ColumnSizeHash = NULL;
+
+/* Start of the last statement whose servers were prepared by its first scan */
+static TimestampTz servers_prepared_ts = 0;
+
+/*
+ * Bound buffer of a single INSERT, UPDATE or DELETE parameter. The buffer holds batch_size value
+ * slots of width bytes each, and is bound to the statement once; executing a row only copies values
+ * into the slots. Integers, floats, dates, timestamps and bytea are bound in their binary C types,
+ * and any other type as the text made by its output function. The ROWID parameter of UPDATE and
+ * DELETE has SelfItemPointerAttributeNumber as its attnum.
+ */
+typedef struct TbParamBuffer
+{
+	int attnum;
+	Oid pg_type;
+	SQLSMALLINT c_type;
+	FmgrInfo flinfo;
+
+	SQLLEN width;
+	char *data;
+	SQLLEN *ind;
+} TbParamBuffer;
+
 typedef struct TbFdwExecState
 {
 	char *query;
+	CmdType operation;
 	List *target_attrs;
+	AttrNumber rowid_attno;
 
 	int p_nums;
-	FmgrInfo *p_flinfo;
+	TbParamBuffer *params;
+
+	int batch_size;
+	int commit_size;
+	int uncommitted_rows;
+
+	/* INSERT is sent as a MERGE that skips rows with a conflicting key */
+	bool skip_conflicts;
+	SQLULEN p_set_size;
+	SQLUSMALLINT *p_status;
+	SQLULEN p_processed;
+
+	/* Rows of UPDATE or DELETE stored in the buffers and not yet sent */
+	int num_queued;
 
 	MemoryContext temp_ctx;
 	TbStatement *tbStmt;
 } TbFdwExecState;
 
+typedef struct TbFdwDirectModifyState
+{
+	char *query;
+	bool set_processed;
+
+	bool executed;
+	int num_tuples;
+
+	TbStatement *tbStmt;
+} TbFdwDirectModifyState;
+
+void _PG_init(void);
+
 PG_FUNCTION_INFO_V1(tibero_fdw_handler);
 
 /* {{{ FDW callback routines **********************************************************************/
@@ -166,11 +274,31 @@ static void tiberoExplainForeignScan(ForeignScanState *node, ExplainState *ex);
 static int tiberoIsForeignRelUpdatable(Relation rel);
 static List *tiberoPlanForeignModify(PlannerInfo *root, ModifyTable *plan, Index resultRelation,
 																		 int subplan_index);
+static void tiberoAddForeignUpdateTargets(PlannerInfo *root, Index rtindex,
+																					RangeTblEntry *target_rte, Relation target_relation);
 static void tiberoBeginForeignModify(ModifyTableState *mtstate, ResultRelInfo *resultRelInfo,
 																		 List *fdw_private, int subplan_index, int eflags);
+static TupleTableSlot *tiberoExecForeignUpdate(EState *estate, ResultRelInfo *resultRelInfo,
+																							 TupleTableSlot *slot, TupleTableSlot *planSlot);
+static TupleTableSlot *tiberoExecForeignDelete(EState *estate, ResultRelInfo *resultRelInfo,
+																							 TupleTableSlot *slot, TupleTableSlot *planSlot);
 static TupleTableSlot *tiberoExecForeignInsert(EState *estate, ResultRelInfo *resultRelInfo,
 																							 TupleTableSlot *slot, TupleTableSlot *planSlot);
 static void tiberoEndForeignModify(EState *estate, ResultRelInfo *resultRelInfo);
+static void tiberoBeginForeignInsert(ModifyTableState *mtstate, ResultRelInfo *resultRelInfo);
+static void tiberoEndForeignInsert(EState *estate, ResultRelInfo *resultRelInfo);
+static int tiberoGetForeignModifyBatchSize(ResultRelInfo *resultRelInfo);
+static TupleTableSlot **tiberoExecForeignBatchInsert(EState *estate, ResultRelInfo *resultRelInfo,
+																										 TupleTableSlot **slots,
+																										 TupleTableSlot **planSlots, int *numSlots);
+static bool tiberoPlanDirectModify(PlannerInfo *root, ModifyTable *plan, Index resultRelation,
+																	 int subplan_index);
+static void tiberoBeginDirectModify(ForeignScanState *node, int eflags);
+static TupleTableSlot *tiberoIterateDirectModify(ForeignScanState *node);
+static void tiberoEndDirectModify(ForeignScanState *node);
+static void tiberoExplainDirectModify(ForeignScanState *node, ExplainState *es);
+static void tiberoExecForeignTruncate(List *rels, DropBehavior behavior, bool restart_seqs);
+static List *tiberoImportForeignSchema(ImportForeignSchemaStmt *stmt, Oid serverOid);
 /********************************************************************** FDW callback routines }}} */
 
 /* {{{ Helper functions ***************************************************************************/
@@ -178,8 +306,73 @@ static bool foreign_join_ok(PlannerInfo *root, RelOptInfo *joinrel, JoinType joi
 														RelOptInfo *outerrel, RelOptInfo *innerrel, JoinPathExtraData *extra);
 static inline bool foreign_scan_has_upper_rels(List *fdw_private);
 static inline StringInfo get_foreign_scan_upper_rel_names(ForeignScan *plan, ExplainState *es);
+static List *build_rowid_scan_tlist(PlannerInfo *root, RelOptInfo *baserel, List *retrieved_attrs);
+static Datum make_wholerow_datum(TbFdwScanState *fsstate, Datum *dvalues, bool *nulls);
+static void alloc_result_columns(TbFdwScanState *fsstate, SQLSMALLINT col_cnt);
+static void describe_result_columns(TbFdwScanState *fsstate);
+static void bind_result_columns(TbFdwScanState *fsstate);
+static bool result_truncated(TbFdwScanState *fsstate);
+static void prepare_foreign_servers(EState *estate);
+static List *get_column_sizes(Oid relid, Oid userid, List *retrieved_attrs);
+static void remember_column_sizes(TbFdwScanState *fsstate);
+static void forget_column_sizes(Oid relid);
+static void refetch_truncated_values(TbFdwScanState *fsstate);
+static void column_size_relcache_callback(Datum arg, Oid relid);
+static void column_size_syscache_callback(Datum arg, int cacheid, uint32 hashvalue);
+static TbFdwExecState *create_foreign_modify(EState *estate, Relation rel, Oid userid,
+																						 CmdType operation, char *query, List *target_attrs,
+																						 int batch_size);
+static void finish_foreign_modify(TbFdwExecState *fmstate);
+static Oid get_rte_check_as_user(PlannerInfo *root, Index rtindex);
+static int get_batch_size_option(Relation rel);
+static bool get_bulk_load_option(Relation rel, int *commit_size);
+static List *get_key_attrs(Relation rel);
+static void deparse_insert_for_conflict(StringInfo buf, RangeTblEntry *rte, Index rtindex,
+																				Relation rel, List *targetAttrs,
+																				OnConflictAction onConflictAction);
+static SQLSMALLINT get_param_c_type(Oid pg_type);
+static SQLLEN get_param_width(Form_pg_attribute attr, SQLSMALLINT c_type);
+static void set_param_value(TbFdwExecState *fmstate, int pindex, int row, Datum value);
+static void timestamp_to_tb_timestamp(Timestamp ts, TIMESTAMP_STRUCT *tb_ts);
+static void bind_param_buffer(TbFdwExecState *fmstate, int pindex);
+static void grow_param_buffer(TbFdwExecState *fmstate, int pindex, SQLLEN width, int filled);
+static int execute_foreign_insert(TbFdwExecState *fmstate, TupleTableSlot **slots, int num_slots);
+static bool queue_foreign_modify(TbFdwExecState *fmstate, TupleTableSlot *slot,
+																 TupleTableSlot *planSlot);
+static void store_foreign_row(TbFdwExecState *fmstate, TupleTableSlot *slot,
+															TupleTableSlot *planSlot, int row);
+static void execute_foreign_modify(TbFdwExecState *fmstate, int num_rows);
+static char *fold_remote_name(const char *remote_name);
+static char *fold_local_name(const char *local_name);
+static void append_pg_type_for_tb_type(StringInfo buf, const char *tb_type, SQLINTEGER precision,
+																			 bool has_precision, SQLINTEGER scale, bool has_scale,
+																			 SQLINTEGER char_length);
 /*************************************************************************** Helper functions }}} */
 
+void
+_PG_init(void)
+{
+	DefineCustomStringVariable("tibero_fdw.preconnect_servers",
+														 "Foreign servers to connect to when the session starts.",
+														 "Comma-separated server names, used when tibero_fdw is loaded through "
+														 "session_preload_libraries.",
+														 &preconnect_servers,
+														 "",
+														 PGC_BACKEND,
+														 GUC_LIST_INPUT,
+														 NULL, NULL, NULL);
+
+	init_tb_shmem();
+
+#if PG_VERSION_NUM >= 150000
+	MarkGUCPrefixReserved("tibero_fdw");
+#else
+	EmitWarningsOnPlaceholders("tibero_fdw");
+#endif
+
+	preconnect_tb_servers(preconnect_servers);
+}
+
 Datum
 tibero_fdw_handler(PG_FUNCTION_ARGS)
 {
@@ -202,10 +395,28 @@ tibero_fdw_handler(PG_FUNCTION_ARGS)
 
 	/* Support functions for updating foreign tables */
 	routine->IsForeignRelUpdatable = tiberoIsForeignRelUpdatable;
+	routine->AddForeignUpdateTargets = tiberoAddForeignUpdateTargets;
 	routine->PlanForeignModify = tiberoPlanForeignModify;
 	routine->BeginForeignModify = tiberoBeginForeignModify;
 	routine->ExecForeignInsert = tiberoExecForeignInsert;
+	routine->ExecForeignUpdate = tiberoExecForeignUpdate;
+	routine->ExecForeignDelete = tiberoExecForeignDelete;
+	routine->ExecForeignBatchInsert = tiberoExecForeignBatchInsert;
+	routine->GetForeignModifyBatchSize = tiberoGetForeignModifyBatchSize;
 	routine->EndForeignModify = tiberoEndForeignModify;
+	routine->BeginForeignInsert = tiberoBeginForeignInsert;
+	routine->EndForeignInsert = tiberoEndForeignInsert;
+	routine->PlanDirectModify = tiberoPlanDirectModify;
+	routine->BeginDirectModify = tiberoBeginDirectModify;
+	routine->IterateDirectModify = tiberoIterateDirectModify;
+	routine->EndDirectModify = tiberoEndDirectModify;
+	routine->ExplainDirectModify = tiberoExplainDirectModify;
+
+	/* Support functions for TRUNCATE */
+	routine->ExecForeignTruncate = tiberoExecForeignTruncate;
+
+	/* Support functions for IMPORT FOREIGN SCHEMA */
+	routine->ImportForeignSchema = tiberoImportForeignSchema;
 
 	PG_RETURN_POINTER(routine);
 }
@@ -377,6 +588,7 @@ tiberoGetForeignPlan(PlannerInfo *root, RelOptInfo *foreignrel, Oid foreigntable
 	bool has_limit = false;
 	ListCell *lc;
 	ForeignScan *result_foreign_scan = NULL;
+	Oid userid;
 
 	set_sleep_on_sig_on();
 
@@ -405,6 +617,9 @@ tiberoGetForeignPlan(PlannerInfo *root, RelOptInfo *foreignrel, Oid foreigntable
 		}
 
 		fdw_recheck_quals = remote_exprs;
+
+		/* Kept for PlanDirectModify, which ships them with the modification */
+		fpinfo->final_remote_exprs = remote_exprs;
 	} else {
 		scan_relid = 0;
 		Assert(false);
@@ -415,8 +630,24 @@ tiberoGetForeignPlan(PlannerInfo *root, RelOptInfo *foreignrel, Oid foreigntable
 															best_path->path.pathkeys, has_final_sort, has_limit, false,
 															&retrieved_attrs, &params_list, fpinfo->use_fb_query);
 
-	fdw_private = list_make4(makeString(sql.data), retrieved_attrs, makeInteger(fpinfo->fetch_size),
-													 makeInteger(fpinfo->use_fb_query));
+	userid = get_rte_check_as_user(root, foreignrel->relid);
+	if (!OidIsValid(userid))
+		userid = GetUserId();
+
+	fdw_private = list_make5(makeString(sql.data), retrieved_attrs, makeInteger(fpinfo->fetch_size),
+													 makeInteger(fpinfo->use_fb_query),
+													 get_column_sizes(foreigntableid, userid, retrieved_attrs));
+	fdw_private = lappend(fdw_private, makeInteger((int) userid));
+
+	/*
+	 * ROWID of an UPDATE or DELETE target is text and cannot be kept in the ctid of a heap tuple, so
+	 * such a scan returns the tuple described by its own target list. The remote conditions may use
+	 * columns that are not fetched, so they are not rechecked on the scan tuple.
+	 */
+	if (list_member_int(retrieved_attrs, SelfItemPointerAttributeNumber)) {
+		fdw_scan_tlist = build_rowid_scan_tlist(root, foreignrel, retrieved_attrs);
+		fdw_recheck_quals = NIL;
+	}
 
 	Assert(IS_SIMPLE_REL(foreignrel));
 
@@ -468,10 +699,16 @@ tiberoBeginForeignScan(ForeignScanState *node, int eflags)
 	fsstate->retrieved_attrs = (List *) list_nth(fsplan->fdw_private, FdwScanPrivateRetrievedAttrs);
 	fsstate->fetch_size = intVal(list_nth(fsplan->fdw_private, FdwScanPrivateFetchSize));
 	fsstate->use_fb_query = intVal(list_nth(fsplan->fdw_private, FdwScanPrivateUseFbQuery));
+	fsstate->userid = userid;
+
+	/* Sizes remembered for another user may belong to another remote table */
+	if ((Oid) intVal(list_nth(fsplan->fdw_private, FdwScanPrivateColumnSizesUser)) == userid)
+		fsstate->column_sizes = (List *) list_nth(fsplan->fdw_private, FdwScanPrivateColumnSizes);
 
 	fsstate->tuple_cnt = TB_FDW_INIT_TUPLE_CNT;
 	fsstate->cur_tuple_idx = 0;
 	fsstate->end_of_fetch = false;
+	fsstate->first_fetch = true;
 
 	fsstate->batch_ctx = AllocSetContextCreate(estate->es_query_cxt, "tibero_fdw tuple data",
 																						 ALLOCSET_DEFAULT_SIZES);
@@ -479,48 +716,415 @@ tiberoBeginForeignScan(ForeignScanState *node, int eflags)
 																						ALLOCSET_SMALL_SIZES);
 
 	fsstate->rel = node->ss.ss_currentRelation;
-	fsstate->tupdesc = RelationGetDescr(fsstate->rel);
+	fsstate->wholerow_pos = -1;
+	if (fsplan->fdw_scan_tlist != NIL) {
+		/* The retrieved attributes in order, followed by the whole row if requested */
+		fsstate->has_scan_tlist = true;
+		fsstate->tupdesc = node->ss.ss_ScanTupleSlot->tts_tupleDescriptor;
+		if (list_length(fsplan->fdw_scan_tlist) > list_length(fsstate->retrieved_attrs))
+			fsstate->wholerow_pos = list_length(fsstate->retrieved_attrs);
+	} else {
+		fsstate->tupdesc = RelationGetDescr(fsstate->rel);
+	}
 
 	fsstate->attinmeta = TupleDescGetAttInMetadata(fsstate->tupdesc);
 
+	if (servers_prepared_ts != GetCurrentStatementStartTimestamp()) {
+		servers_prepared_ts = GetCurrentStatementStartTimestamp();
+		prepare_foreign_servers(estate);
+	}
+
+	fsstate->tbStmt = (TbStatement *) palloc0(sizeof(TbStatement));
+	get_tb_prepared_statement(user, fsstate->tbStmt, fsstate->use_fb_query, (char *) fsstate->query);
+
+	/* Bind with the sizes known at plan time if any, sparing the describe of every column */
+	if (fsstate->column_sizes != NIL) {
+		ListCell *lc;
+
+		alloc_result_columns(fsstate, list_length(fsstate->column_sizes));
+		i = 0;
+		foreach(lc, fsstate->column_sizes) {
+			fsstate->table->column[i++]->col_size = (SQLUINTEGER) lfirst_int(lc);
+		}
+		fsstate->sizes_from_plan = true;
+	} else {
+		describe_result_columns(fsstate);
+	}
+
+	if (fsstate->use_fb_query && !IsolationUsesXactSnapshot()) {
+		TbSQLBindParameter(fsstate->tbStmt, 1, SQL_PARAM_INPUT, SQL_C_CHAR, NUMERICOID, 0, 0,
+											 fsstate->tbStmt->conn->tsn, strlen(fsstate->tbStmt->conn->tsn), NULL);
+	}
+
+	TbSQLSetStmtAttr(fsstate->tbStmt, SQL_ATTR_ROW_ARRAY_SIZE, (SQLPOINTER)fsstate->fetch_size, 0);
+	TbSQLSetStmtAttr(fsstate->tbStmt, SQL_ATTR_ROWS_FETCHED_PTR, (SQLPOINTER)&fsstate->tuple_cnt, 0);
+
+	bind_result_columns(fsstate);
+
+	fsstate->tbStmt->query_executed = false;
+
+	set_sleep_on_sig_off();
+}
+
+/*
+ * Connects to all the Tibero servers the statement reads, and then takes the flashback TSNs of
+ * those read with flashback queries, together before its first scan uses its own connection.
+ */
+static void
+prepare_foreign_servers(EState *estate)
+{
+	List *umids = NIL;
+	List *users = NIL;
+	List *fb_umids = NIL;
+	List *fb_users = NIL;
+	ListCell *lc;
+
+	foreach(lc, estate->es_range_table) {
+		RangeTblEntry *rte = lfirst_node(RangeTblEntry, lc);
+		ForeignTable *table;
+		ForeignServer *server;
+		UserMapping *user;
+		bool use_fb_query = false;
+		Oid userid;
+		ListCell *opt;
+
+		if (rte->rtekind != RTE_RELATION || rte->relkind != RELKIND_FOREIGN_TABLE)
+			continue;
+
+		table = GetForeignTable(rte->relid);
+		if (GetFdwRoutineByServerId(table->serverid)->BeginForeignScan != tiberoBeginForeignScan)
+			continue;
+
+#if PG_VERSION_NUM >= 160000
+		userid = rte->perminfoindex != 0 ?
+			getRTEPermissionInfo(estate->es_rteperminfos, rte)->checkAsUser : InvalidOid;
+#else
+		userid = rte->checkAsUser;
+#endif
+		user = GetUserMapping(OidIsValid(userid) ? userid : GetUserId(), table->serverid);
+
+		/* The table option overrides the server option */
+		server = GetForeignServer(table->serverid);
+		foreach(opt, server->options) {
+			DefElem *def = (DefElem *) lfirst(opt);
+			if (strcmp(def->defname, "use_fb_query") == 0)
+				use_fb_query = defGetBoolean(def);
+		}
+		foreach(opt, table->options) {
+			DefElem *def = (DefElem *) lfirst(opt);
+			if (strcmp(def->defname, "use_fb_query") == 0)
+				use_fb_query = defGetBoolean(def);
+		}
+
+		if (!list_member_oid(umids, user->umid)) {
+			umids = lappend_oid(umids, user->umid);
+			users = lappend(users, user);
+		}
+		if (use_fb_query && !list_member_oid(fb_umids, user->umid)) {
+			fb_umids = lappend_oid(fb_umids, user->umid);
+			fb_users = lappend(fb_users, user);
+		}
+	}
+
+	if (list_length(users) > 1)
+		connect_tb_servers(users);
+
+	if (list_length(fb_users) > 1 && !IsolationUsesXactSnapshot())
+		prefetch_tb_snapshots(fb_users);
+
+	list_free(umids);
+	list_free(users);
+	list_free(fb_umids);
+	list_free(fb_users);
+}
+
+/*
+ * Allocates the column descriptions of the result of a scan.
+ */
+static void
+alloc_result_columns(TbFdwScanState *fsstate, SQLSMALLINT col_cnt)
+{
+	int i;
+
+	fsstate->tbStmt->res_col_cnt = col_cnt;
+
 	fsstate->table = (TbTable *) palloc0(sizeof(TbTable));
-	fsstate->table->column = (TbColumn **) palloc0(sizeof(TbColumn *) * fsstate->tupdesc->natts);
-	for (i = 0; i < fsstate->tupdesc->natts; i++) {
+	fsstate->table->column = (TbColumn **) palloc0(sizeof(TbColumn *) * col_cnt);
+	for (i = 0; i < col_cnt; i++) {
 		fsstate->table->column[i] = (TbColumn *) palloc0(sizeof(TbColumn));
 	}
+}
 
-	fsstate->tbStmt = (TbStatement *) palloc0(sizeof(TbStatement));
-	get_tb_statement(user, fsstate->tbStmt, fsstate->use_fb_query);
+/*
+ * Describes the result columns of the prepared query, and remembers their sizes for the scans of
+ * the relation planned afterwards.
+ */
+static void
+describe_result_columns(TbFdwScanState *fsstate)
+{
+	SQLSMALLINT col_cnt;
+	int i;
 
-	TbSQLPrepare(fsstate->tbStmt, (SQLCHAR *)fsstate->query, SQL_NTS);
-	TbSQLNumResultCols(fsstate->tbStmt, &fsstate->tbStmt->res_col_cnt);
+	TbSQLNumResultCols(fsstate->tbStmt, &col_cnt);
+	alloc_result_columns(fsstate, col_cnt);
 
-	for (i = 0; i < fsstate->tbStmt->res_col_cnt; i++) {
+	for (i = 0; i < col_cnt; i++) {
 		TbColumn *col = fsstate->table->column[i];
 		TbSQLDescribeCol(fsstate->tbStmt, (SQLSMALLINT)i + 1, col->col_name, sizeof(col->col_name),
 										 &col->col_name_len, &col->data_type, &col->col_size, &col->scale,
 										 &col->nullable);
+	}
+
+	fsstate->sizes_from_plan = false;
+	remember_column_sizes(fsstate);
+}
+
+/*
+ * Allocates a buffer of fetch_size values for each result column and binds it.
+ */
+static void
+bind_result_columns(TbFdwScanState *fsstate)
+{
+	int i;
+
+	for (i = 0; i < fsstate->tbStmt->res_col_cnt; i++) {
+		TbColumn *col = fsstate->table->column[i];
 
 		col->data = palloc0(sizeof(unsigned char) * col->col_size * fsstate->fetch_size);
 		col->ind = palloc0(sizeof(SQLLEN) * fsstate->fetch_size);
+		TbSQLBindCol(fsstate->tbStmt, i + 1, SQL_C_CHAR, (SQLCHAR *)col->data, col->col_size, col->ind);
 	}
+}
 
-	if (fsstate->use_fb_query && !IsolationUsesXactSnapshot()) {
-		TbSQLBindParameter(fsstate->tbStmt, 1, SQL_PARAM_INPUT, SQL_C_CHAR, NUMERICOID, 0, 0,
-											 fsstate->tbStmt->conn->tsn, strlen(fsstate->tbStmt->conn->tsn), NULL);
+/*
+ * Checks whether a fetched value did not fit its buffer. This happens only to buffers bound with
+ * sizes known at plan time, once the remote column has been widened since it was described.
+ */
+static bool
+result_truncated(TbFdwScanState *fsstate)
+{
+	int i, j;
+
+	for (i = 0; i < fsstate->tbStmt->res_col_cnt; i++) {
+		TbColumn *col = fsstate->table->column[i];
+
+		for (j = 0; j < fsstate->tuple_cnt; j++) {
+			if (col->ind[j] == SQL_NO_TOTAL || col->ind[j] >= (SQLLEN) col->col_size)
+				return true;
+		}
 	}
 
-	TbSQLSetStmtAttr(fsstate->tbStmt, SQL_ATTR_ROW_ARRAY_SIZE, (SQLPOINTER)fsstate->fetch_size, 0);
-	TbSQLSetStmtAttr(fsstate->tbStmt, SQL_ATTR_ROWS_FETCHED_PTR, (SQLPOINTER)&fsstate->tuple_cnt, 0);
+	return false;
+}
 
-	for (i = 0; i < fsstate->tbStmt->res_col_cnt; i++) {
+/*
+ * Completes a fetched block whose values did not fit the buffers bound with sizes known at plan
+ * time, once the remote columns were widened. The result is described again, the values cut short
+ * are read again by SQLGetData, and each widened column is bound to a buffer of its new size for the
+ * blocks that follow.
+ */
+static void
+refetch_truncated_values(TbFdwScanState *fsstate)
+{
+	TbStatement *tbStmt = fsstate->tbStmt;
+	SQLSMALLINT col_cnt = tbStmt->res_col_cnt;
+	SQLUINTEGER *old_sizes = palloc(sizeof(SQLUINTEGER) * col_cnt);
+	unsigned char **old_data = palloc(sizeof(unsigned char *) * col_cnt);
+	int i, j;
+
+	for (i = 0; i < col_cnt; i++) {
 		TbColumn *col = fsstate->table->column[i];
-		TbSQLBindCol(fsstate->tbStmt, i + 1, SQL_C_CHAR, (SQLCHAR *)col->data, col->col_size, col->ind);
+		SQLULEN col_size;
+
+		old_sizes[i] = col->col_size;
+		old_data[i] = col->data;
+
+		TbSQLDescribeCol(tbStmt, (SQLSMALLINT)i + 1, col->col_name, sizeof(col->col_name),
+										 &col->col_name_len, &col->data_type, &col_size, &col->scale, &col->nullable);
+		if (col_size <= old_sizes[i])
+			continue;
+
+		/* The buffer lives as long as the scan, like the one it replaces */
+		col->col_size = (SQLUINTEGER) col_size;
+		col->data = MemoryContextAllocZero(GetMemoryChunkContext(old_data[i]),
+																			 sizeof(unsigned char) * col->col_size * fsstate->fetch_size);
+		for (j = 0; j < fsstate->tuple_cnt; j++)
+			memcpy(&col->data[j * col->col_size], &old_data[i][j * old_sizes[i]], old_sizes[i]);
+
+		/* A bound column may not be read by SQLGetData */
+		TbSQLBindCol(tbStmt, i + 1, SQL_C_CHAR, NULL, 0, NULL);
 	}
 
-	fsstate->tbStmt->query_executed = false;
+	for (j = 0; j < fsstate->tuple_cnt; j++) {
+		bool positioned = false;
 
-	set_sleep_on_sig_off();
+		for (i = 0; i < col_cnt; i++) {
+			TbColumn *col = fsstate->table->column[i];
+
+			if (col->ind[j] != SQL_NO_TOTAL && col->ind[j] < (SQLLEN) old_sizes[i])
+				continue;
+
+			if (col->col_size > old_sizes[i]) {
+				if (!positioned) {
+					TbSQLSetPos(tbStmt, (SQLUSMALLINT) (j + 1), SQL_POSITION, SQL_LOCK_NO_CHANGE);
+					positioned = true;
+				}
+				TbSQLGetData(tbStmt, (SQLUSMALLINT) (i + 1), SQL_C_CHAR, &col->data[j * col->col_size],
+										 col->col_size, &col->ind[j]);
+			}
+
+			if (col->ind[j] == SQL_NO_TOTAL || col->ind[j] >= (SQLLEN) col->col_size)
+				ereport(ERROR,
+								(errcode(ERRCODE_FDW_ERROR),
+								 errmsg("value in column \"%s\" of foreign table \"%s\" is too long",
+												(char *) col->col_name, RelationGetRelationName(fsstate->rel))));
+		}
+	}
+
+	for (i = 0; i < col_cnt; i++) {
+		TbColumn *col = fsstate->table->column[i];
+
+		if (col->col_size == old_sizes[i])
+			continue;
+
+		TbSQLBindCol(tbStmt, i + 1, SQL_C_CHAR, (SQLCHAR *)col->data, col->col_size, col->ind);
+		pfree(old_data[i]);
+	}
+
+	remember_column_sizes(fsstate);
+
+	pfree(old_sizes);
+	pfree(old_data);
+}
+
+/*
+ * Returns the buffer sizes of the retrieved attributes of a foreign table as remembered from an
+ * earlier scan, or NIL if any of them is unknown. ROWID always has the same size.
+ */
+static List *
+get_column_sizes(Oid relid, Oid userid, List *retrieved_attrs)
+{
+	TbColumnSizeKey key;
+	TbColumnSizeEntry *entry;
+	List *sizes = NIL;
+	ListCell *lc;
+
+	if (ColumnSizeHash == NULL || retrieved_attrs == NIL)
+		return NIL;
+
+	key.relid = relid;
+	key.userid = userid;
+	entry = (TbColumnSizeEntry *) hash_search(ColumnSizeHash, &key, HASH_FIND, NULL);
+
+	foreach(lc, retrieved_attrs) {
+		int attnum = lfirst_int(lc);
+
+		if (attnum == SelfItemPointerAttributeNumber) {
+			sizes = lappend_int(sizes, EROWID_SIZE + 1);
+		} else if (entry != NULL && attnum > 0 && attnum <= entry->natts &&
+							 entry->col_sizes[attnum - 1] > 0) {
+			sizes = lappend_int(sizes, (int) entry->col_sizes[attnum - 1]);
+		} else {
+			list_free(sizes);
+			return NIL;
+		}
+	}
+
+	return sizes;
+}
+
+static void
+remember_column_sizes(TbFdwScanState *fsstate)
+{
+	TbColumnSizeKey key;
+	TbColumnSizeEntry *entry;
+	ListCell *lc;
+	bool found;
+	int i = 0;
+
+	/* A query retrieving no attribute selects a NULL that is not worth remembering */
+	if (fsstate->tbStmt->res_col_cnt != list_length(fsstate->retrieved_attrs))
+		return;
+
+	if (ColumnSizeHash == NULL) {
+		HASHCTL ctl;
+
+		ctl.keysize = sizeof(TbColumnSizeKey);
+		ctl.entrysize = sizeof(TbColumnSizeEntry);
+		ColumnSizeHash = hash_create("tibero_fdw column sizes", 64, &ctl, HASH_ELEM|HASH_BLOBS);
+
+		CacheRegisterRelcacheCallback(column_size_relcache_callback, (Datum) 0);
+		CacheRegisterSyscacheCallback(FOREIGNSERVEROID, column_size_syscache_callback, (Datum) 0);
+		CacheRegisterSyscacheCallback(USERMAPPINGOID, column_size_syscache_callback, (Datum) 0);
+		CacheRegisterSyscacheCallback(FOREIGNTABLEREL, column_size_syscache_callback, (Datum) 0);
+	}
+
+	key.relid = RelationGetRelid(fsstate->rel);
+	key.userid = fsstate->userid;
+	entry = (TbColumnSizeEntry *) hash_search(ColumnSizeHash, &key, HASH_ENTER, &found);
+	if (!found) {
+		entry->natts = RelationGetDescr(fsstate->rel)->natts;
+		entry->col_sizes = (SQLUINTEGER *) MemoryContextAllocZero(CacheMemoryContext,
+																															sizeof(SQLUINTEGER) * entry->natts);
+	}
+
+	foreach(lc, fsstate->retrieved_attrs) {
+		int attnum = lfirst_int(lc);
+
+		if (attnum > 0 && attnum <= entry->natts)
+			entry->col_sizes[attnum - 1] = fsstate->table->column[i]->col_size;
+		i++;
+	}
+}
+
+/*
+ * Forgets the sizes remembered for the foreign table, for every user.
+ */
+static void
+forget_column_sizes(Oid relid)
+{
+	HASH_SEQ_STATUS scan;
+	TbColumnSizeEntry *entry;
+
+	if (ColumnSizeHash == NULL)
+		return;
+
+	hash_seq_init(&scan, ColumnSizeHash);
+	while ((entry = (TbColumnSizeEntry *) hash_seq_search(&scan))) {
+		if (entry->key.relid != relid)
+			continue;
+		pfree(entry->col_sizes);
+		hash_search(ColumnSizeHash, &entry->key, HASH_REMOVE, NULL);
+	}
+}
+
+static void
+column_size_relcache_callback(Datum arg, Oid relid)
+{
+	if (OidIsValid(relid))
+		forget_column_sizes(relid);
+	else
+		column_size_syscache_callback(arg, 0, 0);
+}
+
+/*
+ * A changed server, user mapping or table option may point the foreign tables at other remote
+ * tables, so every remembered size is forgotten.
+ */
+static void
+column_size_syscache_callback(Datum arg, int cacheid, uint32 hashvalue)
+{
+	HASH_SEQ_STATUS scan;
+	TbColumnSizeEntry *entry;
+
+	if (ColumnSizeHash == NULL)
+		return;
+
+	hash_seq_init(&scan, ColumnSizeHash);
+	while ((entry = (TbColumnSizeEntry *) hash_seq_search(&scan))) {
+		pfree(entry->col_sizes);
+		hash_search(ColumnSizeHash, &entry->key, HASH_REMOVE, NULL);
+	}
 }
 
 static Datum
@@ -599,7 +1203,7 @@ make_tuples(ForeignScanState *node)
 	for (i = 0; i < fsstate->tuple_cnt; i++) {
 		attid = 0;
 		foreach(lc, fsstate->retrieved_attrs) {
-			int attnum = lfirst_int(lc) - 1;
+			int attnum = fsstate->has_scan_tlist ? attid : lfirst_int(lc) - 1;
 			Oid pgtype = TupleDescAttr(attinmeta->tupdesc, attnum)->atttypid;
 			int32 pgtypmod = TupleDescAttr(attinmeta->tupdesc, attnum)->atttypmod;
 
@@ -612,6 +1216,12 @@ make_tuples(ForeignScanState *node)
 			}
 			attid++;
 		}
+
+		if (fsstate->wholerow_pos >= 0) {
+			nulls[fsstate->wholerow_pos] = false;
+			dvalues[fsstate->wholerow_pos] = make_wholerow_datum(fsstate, dvalues, nulls);
+		}
+
 		fsstate->tuples[i] = heap_form_tuple(attinmeta->tupdesc, dvalues, nulls);
 
 		for (j = 0; j < natts; j++) {
@@ -623,11 +1233,68 @@ make_tuples(ForeignScanState *node)
 	MemoryContextSwitchTo(oldcontext);
 }
 
+/*
+ * Makes the whole-row value of the scanned relation from the retrieved columns of a scan tuple laid
+ * out by the scan target list.
+ */
+static Datum
+make_wholerow_datum(TbFdwScanState *fsstate, Datum *dvalues, bool *nulls)
+{
+	TupleDesc reldesc = RelationGetDescr(fsstate->rel);
+	Datum *row_values = palloc0(reldesc->natts * sizeof(Datum));
+	bool *row_nulls = palloc(reldesc->natts * sizeof(bool));
+	HeapTuple row;
+	Datum result;
+	ListCell *lc;
+	int attid = 0;
+
+	memset(row_nulls, true, reldesc->natts * sizeof(bool));
+
+	foreach(lc, fsstate->retrieved_attrs) {
+		int attnum = lfirst_int(lc);
+
+		if (attnum > 0) {
+			row_values[attnum - 1] = dvalues[attid];
+			row_nulls[attnum - 1] = nulls[attid];
+		}
+		attid++;
+	}
+
+	row = heap_form_tuple(reldesc, row_values, row_nulls);
+	result = heap_copy_tuple_as_datum(row, reldesc);
+
+	heap_freetuple(row);
+	pfree(row_values);
+	pfree(row_nulls);
+
+	return result;
+}
+
 static void
 fetch_tuples(ForeignScanState *node)
 {
 	TbFdwScanState *fsstate = (TbFdwScanState *) node->fdw_state;
 	TbSQLFetch(fsstate->tbStmt, &fsstate->cur_tuple_idx, &fsstate->end_of_fetch);
+
+	if (!fsstate->end_of_fetch && fsstate->sizes_from_plan && result_truncated(fsstate)) {
+		forget_column_sizes(RelationGetRelid(fsstate->rel));
+
+		if (fsstate->first_fetch) {
+			/* The remembered sizes are stale, so describe the result and run the query again */
+			TbSQLFreeStmt(fsstate->tbStmt, SQL_CLOSE);
+			TbSQLFreeStmt(fsstate->tbStmt, SQL_UNBIND);
+			describe_result_columns(fsstate);
+			bind_result_columns(fsstate);
+
+			TbSQLExecute(fsstate->tbStmt);
+			TbSQLFetch(fsstate->tbStmt, &fsstate->cur_tuple_idx, &fsstate->end_of_fetch);
+		} else {
+			/* Rows already returned cannot be fetched again, so the block is completed in place */
+			refetch_truncated_values(fsstate);
+		}
+	}
+
+	fsstate->first_fetch = false;
 	if (!fsstate->end_of_fetch) make_tuples(node);
 }
 
@@ -660,6 +1327,7 @@ tiberoReScanForeignScan(ForeignScanState *node)
 	set_sleep_on_sig_on();
 
 	fsstate->end_of_fetch = false;
+	fsstate->first_fetch = true;
 	fsstate->cur_tuple_idx = 0;
 	fsstate->tbStmt->query_executed = false;
 
@@ -676,7 +1344,11 @@ tiberoEndForeignScan(ForeignScanState *node)
 
 	set_sleep_on_sig_on();
 
-	TbSQLFreeStmt(fsstate->tbStmt, SQL_DROP);
+	/* Stops the remote query of a scan ended early, e.g. by LIMIT, rather than letting it run on */
+	if (fsstate->tbStmt->query_executed && !fsstate->end_of_fetch)
+		TbSQLCancel(fsstate->tbStmt);
+
+	release_tb_statement(fsstate->tbStmt);
 
 	set_sleep_on_sig_off();
 }
@@ -689,7 +1361,47 @@ foreign_join_ok(PlannerInfo *root, RelOptInfo *joinrel, JoinType jointype, RelOp
 	return false;
 }
 
-static void
+/*
+ * Builds the target list of a scan fetching ROWID: the retrieved attributes in the order of
+ * retrieved_attrs with ROWID as text, followed by the whole row when the relation is fetched as one.
+ */
+static List *
+build_rowid_scan_tlist(PlannerInfo *root, RelOptInfo *baserel, List *retrieved_attrs)
+{
+	TbFdwRelationInfo *fpinfo = (TbFdwRelationInfo *) baserel->fdw_private;
+	RangeTblEntry *rte = planner_rt_fetch(baserel->relid, root);
+	Relation rel = table_open(rte->relid, NoLock);
+	TupleDesc tupdesc = RelationGetDescr(rel);
+	List *tlist = NIL;
+	ListCell *lc;
+
+	foreach(lc, retrieved_attrs) {
+		int attnum = lfirst_int(lc);
+		Var *var;
+
+		if (attnum == SelfItemPointerAttributeNumber) {
+			var = makeVar(baserel->relid, attnum, TEXTOID, -1, InvalidOid, 0);
+		} else {
+			Form_pg_attribute attr = TupleDescAttr(tupdesc, attnum - 1);
+
+			var = makeVar(baserel->relid, attnum, attr->atttypid, attr->atttypmod, attr->attcollation,
+										0);
+		}
+		tlist = lappend(tlist, makeTargetEntry((Expr *) var, list_length(tlist) + 1, NULL, false));
+	}
+
+	if (bms_is_member(0 - FirstLowInvalidHeapAttributeNumber, fpinfo->attrs_used)) {
+		Var *var = makeWholeRowVar(rte, baserel->relid, 0, false);
+
+		tlist = lappend(tlist, makeTargetEntry((Expr *) var, list_length(tlist) + 1, NULL, false));
+	}
+
+	table_close(rel, NoLock);
+
+	return tlist;
+}
+
+static void
 tiberoGetForeignJoinPaths(PlannerInfo *root, RelOptInfo *joinrel, RelOptInfo *outerrel,
 													RelOptInfo *innerrel, JoinType jointype, JoinPathExtraData *extra)
 {
@@ -844,7 +1556,23 @@ tiberoIsForeignRelUpdatable(Relation rel)
 			updatable = defGetBoolean(def);
 	}
 
-	return updatable ? (1 << CMD_INSERT) : 0;
+	return updatable ? (1 << CMD_INSERT) | (1 << CMD_UPDATE) | (1 << CMD_DELETE) : 0;
+}
+
+/*
+ * Adds the ROWID of the target table as a junk column, so that each row is updated or deleted by its
+ * ROWID on the remote side. ROWID is fetched as text under the attribute number of ctid, which the
+ * deparser maps to ROWID.
+ */
+static void
+tiberoAddForeignUpdateTargets(PlannerInfo *root, Index rtindex, RangeTblEntry *target_rte,
+															Relation target_relation)
+{
+	Var *var;
+
+	var = makeVar(rtindex, SelfItemPointerAttributeNumber, TEXTOID, -1, InvalidOid, 0);
+
+	add_row_identity_var(root, var, rtindex, "rowid");
 }
 
 static List *
@@ -860,25 +1588,52 @@ tiberoPlanForeignModify(PlannerInfo *root, ModifyTable *plan, Index resultRelati
 	TupleDesc tupdesc;
 	int attnum;
 
-	if (operation != CMD_INSERT)
-		return NULL;
-
 	set_sleep_on_sig_on();
 
 	initStringInfo(&sql);
 
 	rel = table_open(rte->relid, NoLock);
 
-	tupdesc = RelationGetDescr(rel);
-	for (attnum = 1; attnum <= tupdesc->natts; attnum++) {
-		Form_pg_attribute attr = TupleDescAttr(tupdesc, attnum - 1);
+	if (operation == CMD_INSERT) {
+		tupdesc = RelationGetDescr(rel);
+		for (attnum = 1; attnum <= tupdesc->natts; attnum++) {
+			Form_pg_attribute attr = TupleDescAttr(tupdesc, attnum - 1);
 
-		if (!attr->attisdropped)
+			if (!attr->attisdropped)
+				targetAttrs = lappend_int(targetAttrs, attnum);
+		}
+	} else if (operation == CMD_UPDATE) {
+		/* Only the changed columns are sent */
+#if PG_VERSION_NUM >= 160000
+		Bitmapset *updatedCols = get_rel_all_updated_cols(root, find_base_rel(root, resultRelation));
+#else
+		Bitmapset *updatedCols = bms_union(rte->updatedCols, rte->extraUpdatedCols);
+#endif
+		int col = -1;
+
+		while ((col = bms_next_member(updatedCols, col)) >= 0) {
+			attnum = col + FirstLowInvalidHeapAttributeNumber;
+
+			if (attnum <= InvalidAttrNumber)
+				elog(ERROR, "system-column update is not supported");
 			targetAttrs = lappend_int(targetAttrs, attnum);
+		}
 	}
 
-	if (operation == CMD_INSERT) {
-		deparse_insert_sql(&sql, root, resultRelation, rel, targetAttrs);
+	switch (operation) {
+		case CMD_INSERT:
+			deparse_insert_for_conflict(&sql, rte, resultRelation, rel, targetAttrs,
+																	plan->onConflictAction);
+			break;
+		case CMD_UPDATE:
+			deparse_update_sql(&sql, rte, resultRelation, rel, targetAttrs);
+			break;
+		case CMD_DELETE:
+			deparse_delete_sql(&sql, rel);
+			break;
+		default:
+			elog(ERROR, "unexpected operation: %d", (int) operation);
+			break;
 	}
 
 	table_close(rel, NoLock);
@@ -892,49 +1647,183 @@ static void
 tiberoBeginForeignModify(ModifyTableState *mtstate, ResultRelInfo *resultRelInfo,
 												 List *fdw_private, int subplan_index, int eflags)
 {
-	TbFdwExecState *fmstate;
 	EState *estate = mtstate->ps.state;
-	Relation rel = resultRelInfo->ri_RelationDesc;
-	AttrNumber n_params;
-	Oid typefnoid = InvalidOid;
-	bool isvarlena = false;
-	ListCell *lc;
-	Oid foreignTableId = InvalidOid;
+	CmdType operation = mtstate->operation;
+	TriggerDesc *trigdesc = resultRelInfo->ri_TrigDesc;
+	TbFdwExecState *fmstate;
 	Oid userid;
-	ForeignServer *server;
-	UserMapping *user;
-	ForeignTable *table;
-#if PG_VERSION_NUM >= 160000
-	ForeignScan *fsplan = (ForeignScan *) mtstate->ps.plan;
-#else
+	int batch_size;
+#if PG_VERSION_NUM < 160000
 	RangeTblEntry *rte;
 #endif
 
-
 	if (eflags & EXEC_FLAG_EXPLAIN_ONLY)
 		return;
 
 	set_sleep_on_sig_on();
 
-
 #if PG_VERSION_NUM >= 160000
-	userid = (fsplan->checkAsUser != InvalidOid) ? fsplan->checkAsUser : GetUserId();
+	userid = ExecGetResultRelCheckAsUser(resultRelInfo, estate);
 #else
 	rte = rt_fetch(resultRelInfo->ri_RangeTableIndex, estate->es_range_table);
 	userid = (rte->checkAsUser != InvalidOid) ? rte->checkAsUser : GetUserId();
 #endif
 
-	foreignTableId = RelationGetRelid(rel);
+	/*
+	 * Updated and deleted rows are queued and sent batch_size at a time. RETURNING and row-level
+	 * triggers need each row modified before the next one is returned, so they disable queueing.
+	 */
+	batch_size = get_batch_size_option(resultRelInfo->ri_RelationDesc);
+	if (operation != CMD_INSERT &&
+			(resultRelInfo->ri_projectReturning != NULL ||
+			 (trigdesc && operation == CMD_UPDATE &&
+				(trigdesc->trig_update_before_row || trigdesc->trig_update_after_row)) ||
+			 (trigdesc && operation == CMD_DELETE &&
+				(trigdesc->trig_delete_before_row || trigdesc->trig_delete_after_row))))
+		batch_size = 1;
+
+	fmstate = create_foreign_modify(estate, resultRelInfo->ri_RelationDesc, userid, operation,
+																	strVal(list_nth(fdw_private, TbFdwModifyQuery)),
+																	(List *) list_nth(fdw_private, TbFdwModifyTargetAttrs),
+																	batch_size);
+	fmstate->skip_conflicts = (operation == CMD_INSERT &&
+														 castNode(ModifyTable, mtstate->ps.plan)->onConflictAction ==
+														 ONCONFLICT_NOTHING);
+
+	if (operation == CMD_UPDATE || operation == CMD_DELETE) {
+		Plan *subplan = outerPlanState(mtstate)->plan;
+
+		fmstate->rowid_attno = ExecFindJunkAttributeInTlist(subplan->targetlist, "rowid");
+		if (!AttributeNumberIsValid(fmstate->rowid_attno))
+			elog(ERROR, "could not find junk rowid column");
+	}
+
+	resultRelInfo->ri_FdwState = fmstate;
+
+	set_sleep_on_sig_off();
+}
+
+/*
+ * Begins an insert into a foreign table which is a target of COPY FROM or a partition chosen by
+ * tuple routing. Such a table has no ModifyTable plan of its own, so the INSERT statement is made
+ * here and each routed partition gets its own statement and parameter buffers.
+ */
+static void
+tiberoBeginForeignInsert(ModifyTableState *mtstate, ResultRelInfo *resultRelInfo)
+{
+	ModifyTable *plan = castNode(ModifyTable, mtstate->ps.plan);
+	EState *estate = mtstate->ps.state;
+	Relation rel = resultRelInfo->ri_RelationDesc;
+	TupleDesc tupdesc = RelationGetDescr(rel);
+	RangeTblEntry *rte;
+	Index rtindex;
+	List *targetAttrs = NIL;
+	StringInfoData sql;
+	Oid userid;
+	int attnum;
+
+	if (resultRelInfo->ri_projectReturning != NULL)
+		ereport(ERROR,
+						(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+						 errmsg("RETURNING is not supported for tuple routing into a foreign table")));
+
+	set_sleep_on_sig_on();
+
+	/* A routed partition is not in the range table; its RTE is made from the relation */
+	rtindex = resultRelInfo->ri_RangeTableIndex;
+	if (rtindex == 0) {
+		rte = makeNode(RangeTblEntry);
+		rte->rtekind = RTE_RELATION;
+		rte->relid = RelationGetRelid(rel);
+		rte->relkind = RELKIND_FOREIGN_TABLE;
+		rtindex = 1;
+	} else {
+		rte = exec_rt_fetch(rtindex, estate);
+	}
+
+#if PG_VERSION_NUM >= 160000
+	userid = ExecGetResultRelCheckAsUser(resultRelInfo, estate);
+#else
+	{
+		ResultRelInfo *rootResultRelInfo = resultRelInfo->ri_RootResultRelInfo;
+		RangeTblEntry *user_rte = rte;
+
+		if (resultRelInfo->ri_RangeTableIndex == 0 && rootResultRelInfo != NULL)
+			user_rte = exec_rt_fetch(rootResultRelInfo->ri_RangeTableIndex, estate);
+		userid = (user_rte->checkAsUser != InvalidOid) ? user_rte->checkAsUser : GetUserId();
+	}
+#endif
+
+	for (attnum = 1; attnum <= tupdesc->natts; attnum++) {
+		Form_pg_attribute attr = TupleDescAttr(tupdesc, attnum - 1);
+
+		if (!attr->attisdropped)
+			targetAttrs = lappend_int(targetAttrs, attnum);
+	}
+
+	initStringInfo(&sql);
+	deparse_insert_for_conflict(&sql, rte, rtindex, rel, targetAttrs,
+															plan ? plan->onConflictAction : ONCONFLICT_NONE);
+
+	resultRelInfo->ri_FdwState = create_foreign_modify(estate, rel, userid, CMD_INSERT, sql.data,
+																										 targetAttrs, get_batch_size_option(rel));
+	((TbFdwExecState *) resultRelInfo->ri_FdwState)->skip_conflicts =
+		(plan && plan->onConflictAction == ONCONFLICT_NOTHING);
+
+	set_sleep_on_sig_off();
+}
+
+static void
+tiberoEndForeignInsert(EState *estate, ResultRelInfo *resultRelInfo)
+{
+	TbFdwExecState *fmstate = (TbFdwExecState *) resultRelInfo->ri_FdwState;
+
+	Assert(fmstate != NULL);
+
+	set_sleep_on_sig_on();
+
+	finish_foreign_modify(fmstate);
+
+	set_sleep_on_sig_off();
+}
 
-	table = GetForeignTable(foreignTableId);
+/*
+ * Creates the execution state of a modification of the given foreign table: prepares the statement
+ * on the remote connection and binds a buffer for each of its parameters.
+ */
+static TbFdwExecState *
+create_foreign_modify(EState *estate, Relation rel, Oid userid, CmdType operation, char *query,
+											List *target_attrs, int batch_size)
+{
+	TbFdwExecState *fmstate;
+	Oid typefnoid = InvalidOid;
+	bool isvarlena = false;
+	ListCell *lc;
+	ForeignServer *server;
+	UserMapping *user;
+	ForeignTable *table;
+	int i;
+
+	table = GetForeignTable(RelationGetRelid(rel));
 	server = GetForeignServer(table->serverid);
 	user = GetUserMapping(userid, server->serverid);
 
 	fmstate = (TbFdwExecState *) palloc0(sizeof(TbFdwExecState));
-	fmstate->query = strVal(list_nth(fdw_private, TbFdwModifyQuery));
-	fmstate->target_attrs = (List *) list_nth(fdw_private, TbFdwModifyTargetAttrs);
-	n_params = list_length(fmstate->target_attrs) + 1;
-	fmstate->p_flinfo = (FmgrInfo *) palloc0(sizeof(FmgrInfo) * n_params);
+	fmstate->query = query;
+	fmstate->operation = operation;
+	fmstate->target_attrs = target_attrs;
+	fmstate->batch_size = batch_size;
+	if (operation == CMD_INSERT)
+		(void) get_bulk_load_option(rel, &fmstate->commit_size);
+	if (fmstate->commit_size > 0 && IsolationUsesXactSnapshot())
+		ereport(ERROR,
+						(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+						 errmsg("\"bulk_load_commit_size\" cannot be used in a %s transaction",
+										IsolationIsSerializable() ? "SERIALIZABLE" : "REPEATABLE READ")));
+	/* One more parameter for the ROWID of UPDATE and DELETE */
+	fmstate->params = (TbParamBuffer *) palloc0(sizeof(TbParamBuffer) *
+																							(list_length(fmstate->target_attrs) + 1));
+	fmstate->p_status = (SQLUSMALLINT *) palloc0(sizeof(SQLUSMALLINT) * fmstate->batch_size);
 
 	fmstate->temp_ctx = AllocSetContextCreate(estate->es_query_cxt, "tibero_fdw temporary data",
 																						ALLOCSET_SMALL_SIZES);
@@ -943,104 +1832,1233 @@ tiberoBeginForeignModify(ModifyTableState *mtstate, ResultRelInfo *resultRelInfo
 	{
 		int attnum = lfirst_int(lc);
 		Form_pg_attribute attr = TupleDescAttr(RelationGetDescr(rel), attnum - 1);
+		TbParamBuffer *param;
 
 		Assert(!attr->attisdropped);
 
+		/* Generated columns are sent as DEFAULT */
+		if (attr->attgenerated)
+			continue;
+
+		param = &fmstate->params[fmstate->p_nums++];
+		param->attnum = attnum;
+		param->pg_type = attr->atttypid;
+		param->c_type = get_param_c_type(attr->atttypid);
 		getTypeOutputInfo(attr->atttypid, &typefnoid, &isvarlena);
-		fmgr_info(typefnoid, &fmstate->p_flinfo[fmstate->p_nums]);
-		fmstate->p_nums++;
+		fmgr_info(typefnoid, &param->flinfo);
+
+		param->width = get_param_width(attr, param->c_type);
+		param->data = (char *) palloc0(param->width * fmstate->batch_size);
+		param->ind = (SQLLEN *) palloc0(sizeof(SQLLEN) * fmstate->batch_size);
 	}
 
-	if (fmstate->p_nums > n_params) {
-		Assert(false);
+	if (operation == CMD_UPDATE || operation == CMD_DELETE) {
+		TbParamBuffer *param = &fmstate->params[fmstate->p_nums++];
+
+		param->attnum = SelfItemPointerAttributeNumber;
+		param->pg_type = TEXTOID;
+		param->c_type = SQL_C_CHAR;
+		getTypeOutputInfo(TEXTOID, &typefnoid, &isvarlena);
+		fmgr_info(typefnoid, &param->flinfo);
+
+		param->width = EROWID_SIZE + 1;
+		param->data = (char *) palloc0(param->width * fmstate->batch_size);
+		param->ind = (SQLLEN *) palloc0(sizeof(SQLLEN) * fmstate->batch_size);
 	}
 
 	fmstate->tbStmt = (TbStatement *) palloc0(sizeof(TbStatement));
-	get_tb_statement(user, fmstate->tbStmt, false);
+	get_tb_prepared_statement(user, fmstate->tbStmt, false, fmstate->query);
+
+	/* A chunk commit would commit the earlier writes on the connection too */
+	if (fmstate->commit_size > 0 && fmstate->tbStmt->conn->xact_writes) {
+		ConnCacheEntry *conn = fmstate->tbStmt->conn;
+
+		release_tb_statement(fmstate->tbStmt);
+		ereport(ERROR,
+						(errcode(ERRCODE_ACTIVE_SQL_TRANSACTION),
+						 errmsg("\"bulk_load_commit_size\" cannot be used after writes to server \"%s\" in the same transaction",
+										conn->servername),
+						 errhint("Run the load in a transaction of its own.")));
+	}
+	mark_tb_xact_writes(fmstate->tbStmt->conn);
 
 	fmstate->tbStmt->query_executed = false;
 
-	TbSQLPrepare(fmstate->tbStmt, (SQLCHAR *)fmstate->query, SQL_NTS);
+	for (i = 0; i < fmstate->p_nums; i++)
+		bind_param_buffer(fmstate, i);
 
-	resultRelInfo->ri_FdwState = fmstate;
+	TbSQLSetStmtAttr(fmstate->tbStmt, SQL_ATTR_PARAM_BIND_TYPE, (SQLPOINTER) SQL_PARAM_BIND_BY_COLUMN,
+									 0);
+	TbSQLSetStmtAttr(fmstate->tbStmt, SQL_ATTR_PARAM_STATUS_PTR, (SQLPOINTER) fmstate->p_status, 0);
+	TbSQLSetStmtAttr(fmstate->tbStmt, SQL_ATTR_PARAMS_PROCESSED_PTR,
+									 (SQLPOINTER) &fmstate->p_processed, 0);
 
-	set_sleep_on_sig_off();
+	return fmstate;
+}
+
+static void
+finish_foreign_modify(TbFdwExecState *fmstate)
+{
+	release_tb_statement(fmstate->tbStmt);
 }
 
 static TupleTableSlot *
 tiberoExecForeignInsert(EState *estate, ResultRelInfo *resultRelInfo, TupleTableSlot *slot,
 												TupleTableSlot *planSlot)
 {
-	TbFdwExecState *fmstate;
-	ListCell *lc;
-	int n_params;
-	MemoryContext old_context;
-	bool *isnull;
-	char **p_values;
-	SQLLEN *inds;
-	int pindex = 0;
-	int findex = 0;
+	TbFdwExecState *fmstate = (TbFdwExecState *) resultRelInfo->ri_FdwState;
+
+	int inserted;
 
 	set_sleep_on_sig_on();
 
-	fmstate = (TbFdwExecState *) resultRelInfo->ri_FdwState;
-	n_params = list_length(fmstate->target_attrs);
+	inserted = execute_foreign_insert(fmstate, &slot, 1);
 
-	old_context = MemoryContextSwitchTo(fmstate->temp_ctx);
+	set_sleep_on_sig_off();
 
-	p_values = (char **) palloc(sizeof(char *) * n_params);
-	isnull = (bool *) palloc0(sizeof(bool) * n_params);
-	inds = (SQLLEN *) palloc(sizeof(SQLLEN) * n_params);
+	return inserted > 0 ? slot : NULL;
+}
 
-	foreach(lc, fmstate->target_attrs) {
-		int attnum = lfirst_int(lc) - 1;
-		Form_pg_attribute attr = TupleDescAttr(slot->tts_tupleDescriptor, attnum);
-		Oid pg_param_type = attr->atttypid;
-		Datum value;
+static TupleTableSlot *
+tiberoExecForeignUpdate(EState *estate, ResultRelInfo *resultRelInfo, TupleTableSlot *slot,
+												TupleTableSlot *planSlot)
+{
+	TbFdwExecState *fmstate = (TbFdwExecState *) resultRelInfo->ri_FdwState;
+	bool found;
 
-		if (attr->attgenerated)
-			continue;
+	set_sleep_on_sig_on();
 
-		value = slot_getattr(slot, attnum + 1, &isnull[attnum]);
-		if (isnull[attnum]) {
-			p_values[pindex] = NULL;
-			inds[pindex] = SQL_NULL_DATA;
-		} else {
-			p_values[pindex] = OutputFunctionCall(&fmstate->p_flinfo[findex], value);
-			inds[pindex] = SQL_NTS;
-		}
+	found = queue_foreign_modify(fmstate, slot, planSlot);
 
-		TbSQLBindParameter(fmstate->tbStmt, attnum + 1, SQL_PARAM_INPUT, SQL_C_CHAR,
-											 pg_param_type, 0, 0,
-											 p_values[pindex], p_values[pindex] ? strlen(p_values[pindex]) : 0,
-											 &inds[pindex]);
-		pindex++;
-		findex++;
-	}
+	set_sleep_on_sig_off();
 
-	if (!fmstate->tbStmt->query_executed) {
-		TbSQLExecute(fmstate->tbStmt);
-	}
+	return found ? slot : NULL;
+}
 
-	MemoryContextSwitchTo(old_context);
-	MemoryContextReset(fmstate->temp_ctx);
+static TupleTableSlot *
+tiberoExecForeignDelete(EState *estate, ResultRelInfo *resultRelInfo, TupleTableSlot *slot,
+												TupleTableSlot *planSlot)
+{
+	TbFdwExecState *fmstate = (TbFdwExecState *) resultRelInfo->ri_FdwState;
+	bool found;
+
+	set_sleep_on_sig_on();
+
+	found = queue_foreign_modify(fmstate, slot, planSlot);
 
 	set_sleep_on_sig_off();
 
-	return slot;
+	return found ? slot : NULL;
 }
 
-static void
-tiberoEndForeignModify(EState *estate, ResultRelInfo *resultRelInfo)
+static TupleTableSlot **
+tiberoExecForeignBatchInsert(EState *estate, ResultRelInfo *resultRelInfo, TupleTableSlot **slots,
+														 TupleTableSlot **planSlots, int *numSlots)
 {
 	TbFdwExecState *fmstate = (TbFdwExecState *) resultRelInfo->ri_FdwState;
 
-	/* When called for EXPLAIN */
-	if (fmstate == NULL) return;
-
 	set_sleep_on_sig_on();
 
-	TbSQLFreeStmt(fmstate->tbStmt, SQL_DROP);
+	/*
+	 * The executor only counts the rows returned here, since batching is off for RETURNING, row
+	 * triggers and check options. Which rows of the batch were skipped does not matter then.
+	 */
+	*numSlots = execute_foreign_insert(fmstate, slots, *numSlots);
 
 	set_sleep_on_sig_off();
+
+	return slots;
+}
+
+static int
+tiberoGetForeignModifyBatchSize(ResultRelInfo *resultRelInfo)
+{
+	TbFdwExecState *fmstate = (TbFdwExecState *) resultRelInfo->ri_FdwState;
+	int batch_size;
+
+	/* should be called only once */
+	Assert(resultRelInfo->ri_BatchSize == 0);
+
+	if (fmstate)
+		batch_size = fmstate->batch_size;
+	else
+		batch_size = get_batch_size_option(resultRelInfo->ri_RelationDesc);
+
+	/*
+	 * Rows must be sent one at a time when there are RETURNING, row-level insert triggers or check
+	 * options of a view, which have to see each row once it is inserted
+	 */
+	if (resultRelInfo->ri_projectReturning != NULL ||
+			resultRelInfo->ri_WithCheckOptions != NIL ||
+			(resultRelInfo->ri_TrigDesc &&
+			 (resultRelInfo->ri_TrigDesc->trig_insert_before_row ||
+				resultRelInfo->ri_TrigDesc->trig_insert_after_row)))
+		return 1;
+
+	return batch_size;
+}
+
+static int
+get_batch_size_option(Relation rel)
+{
+	ForeignTable *table = GetForeignTable(RelationGetRelid(rel));
+	ForeignServer *server = GetForeignServer(table->serverid);
+	int batch_size = DEFAULT_FDW_BATCH_SIZE;
+	ListCell *lc;
+
+	foreach(lc, server->options) {
+		DefElem *def = (DefElem *) lfirst(lc);
+		if (strcmp(def->defname, "batch_size") == 0)
+			(void) parse_int(defGetString(def), &batch_size, 0, NULL);
+	}
+
+	/* Table option overrides the server option */
+	foreach(lc, table->options) {
+		DefElem *def = (DefElem *) lfirst(lc);
+		if (strcmp(def->defname, "batch_size") == 0)
+			(void) parse_int(defGetString(def), &batch_size, 0, NULL);
+	}
+
+	return batch_size;
+}
+
+/*
+ * Returns whether the table is loaded with direct-path inserts. When commit_size is given, it is set
+ * to the number of rows after which a bulk load commits the remote transaction, or 0 if the load is
+ * committed together with the local transaction.
+ */
+static bool
+get_bulk_load_option(Relation rel, int *commit_size)
+{
+	ForeignTable *table = GetForeignTable(RelationGetRelid(rel));
+	bool bulk_load = false;
+	int bulk_load_commit_size = 0;
+	ListCell *lc;
+
+	foreach(lc, table->options) {
+		DefElem *def = (DefElem *) lfirst(lc);
+		if (strcmp(def->defname, "bulk_load") == 0)
+			bulk_load = defGetBoolean(def);
+		else if (strcmp(def->defname, "bulk_load_commit_size") == 0)
+			(void) parse_int(defGetString(def), &bulk_load_commit_size, 0, NULL);
+	}
+
+	if (commit_size != NULL)
+		*commit_size = bulk_load ? bulk_load_commit_size : 0;
+
+	return bulk_load;
+}
+
+/*
+ * Returns the attribute numbers of the columns marked with the "key" option. They identify a remote
+ * row for ON CONFLICT DO NOTHING, as foreign tables have no unique index of their own.
+ */
+static List *
+get_key_attrs(Relation rel)
+{
+	TupleDesc tupdesc = RelationGetDescr(rel);
+	List *key_attrs = NIL;
+	int attnum;
+
+	for (attnum = 1; attnum <= tupdesc->natts; attnum++) {
+		Form_pg_attribute attr = TupleDescAttr(tupdesc, attnum - 1);
+		ListCell *lc;
+
+		if (attr->attisdropped || attr->attgenerated)
+			continue;
+
+		foreach(lc, GetForeignColumnOptions(RelationGetRelid(rel), attnum)) {
+			DefElem *def = (DefElem *) lfirst(lc);
+
+			if (strcmp(def->defname, "key") == 0 && defGetBoolean(def))
+				key_attrs = lappend_int(key_attrs, attnum);
+		}
+	}
+
+	return key_attrs;
+}
+
+/*
+ * Deparses the statement inserting a row into the foreign table. ON CONFLICT DO NOTHING becomes a
+ * MERGE on the key columns so that an upsert batch still costs a single round trip.
+ */
+static void
+deparse_insert_for_conflict(StringInfo buf, RangeTblEntry *rte, Index rtindex, Relation rel,
+														List *targetAttrs, OnConflictAction onConflictAction)
+{
+	List *key_attrs;
+
+	if (onConflictAction == ONCONFLICT_NONE) {
+		deparse_insert_sql(buf, rte, rtindex, rel, targetAttrs, get_bulk_load_option(rel, NULL));
+		return;
+	}
+
+	/* DO UPDATE needs an arbiter index, which a foreign table never has */
+	if (onConflictAction != ONCONFLICT_NOTHING)
+		ereport(ERROR,
+						(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+						 errmsg("ON CONFLICT DO UPDATE is not supported for tibero_fdw")));
+
+	key_attrs = get_key_attrs(rel);
+	if (key_attrs == NIL)
+		ereport(ERROR,
+						(errcode(ERRCODE_FDW_INVALID_COLUMN_NAME),
+						 errmsg("ON CONFLICT DO NOTHING requires a column with the \"key\" option on \"%s\"",
+										RelationGetRelationName(rel))));
+
+	deparse_merge_insert_sql(buf, rte, rtindex, rel, targetAttrs, key_attrs);
+}
+
+static SQLSMALLINT
+get_param_c_type(Oid pg_type)
+{
+	switch (pg_type) {
+		case INT2OID:
+			return SQL_C_SSHORT;
+		case INT4OID:
+			return SQL_C_SLONG;
+		case INT8OID:
+			return SQL_C_SBIGINT;
+		case FLOAT4OID:
+		case FLOAT8OID:
+			return SQL_C_DOUBLE;
+		case DATEOID:
+		case TIMESTAMPOID:
+			return SQL_C_TYPE_TIMESTAMP;
+		case BYTEAOID:
+			return SQL_C_BINARY;
+		default:
+			return SQL_C_CHAR;
+	}
+}
+
+/*
+ * Returns the initial size of a parameter value slot. Text slots include the NUL terminator and are
+ * sized from the column type and typmod; values that do not fit grow the buffer at execution time.
+ */
+static SQLLEN
+get_param_width(Form_pg_attribute attr, SQLSMALLINT c_type)
+{
+	int32 typmod = attr->atttypmod;
+
+	switch (c_type) {
+		case SQL_C_SSHORT:
+			return sizeof(int16);
+		case SQL_C_SLONG:
+			return sizeof(int32);
+		case SQL_C_SBIGINT:
+			return sizeof(int64);
+		case SQL_C_DOUBLE:
+			return sizeof(double);
+		case SQL_C_TYPE_TIMESTAMP:
+			return sizeof(TIMESTAMP_STRUCT);
+		default:
+			break;
+	}
+
+	switch (attr->atttypid) {
+		case BOOLOID:
+			return 2;
+		case NUMERICOID:
+			/* digits, sign, decimal point and a leading zero */
+			if (typmod >= (int32) VARHDRSZ)
+				return (((typmod - VARHDRSZ) >> 16) & 0xffff) + 4;
+			break;
+		case BPCHAROID:
+		case VARCHAROID:
+			if (typmod >= (int32) VARHDRSZ)
+				return (typmod - VARHDRSZ) * pg_database_encoding_max_length() + 1;
+			break;
+		case TIMEOID:
+		case TIMETZOID:
+		case TIMESTAMPTZOID:
+		case INTERVALOID:
+			return MAXDATELEN + 1;
+		default:
+			break;
+	}
+
+	return DEFAULT_FDW_PARAM_WIDTH;
+}
+
+static void
+bind_param_buffer(TbFdwExecState *fmstate, int pindex)
+{
+	TbParamBuffer *param = &fmstate->params[pindex];
+	SQLULEN col_size = 0;
+	SQLSMALLINT decimal_digits = 0;
+
+	if (param->c_type == SQL_C_CHAR)
+		col_size = param->width - 1;
+	else if (param->c_type == SQL_C_BINARY)
+		col_size = param->width;
+	else if (param->c_type == SQL_C_TYPE_TIMESTAMP)
+		decimal_digits = MAX_TIMESTAMP_PRECISION;
+
+	TbSQLBindParameter(fmstate->tbStmt, pindex + 1, SQL_PARAM_INPUT, param->c_type, param->pg_type,
+										 col_size, decimal_digits, param->data, param->width, param->ind);
+}
+
+/*
+ * Widens the value slots of a parameter buffer keeping the first filled values of the current batch,
+ * and binds the new buffer in place of the old one.
+ */
+static void
+grow_param_buffer(TbFdwExecState *fmstate, int pindex, SQLLEN width, int filled)
+{
+	TbParamBuffer *param = &fmstate->params[pindex];
+	SQLLEN new_width = Max(width, param->width * 2);
+	int i;
+
+	param->data = (char *) repalloc(param->data, new_width * fmstate->batch_size);
+
+	/* Move the filled slots to the new stride, from the last so none overwrites another */
+	for (i = filled - 1; i > 0; i--)
+		memmove(param->data + new_width * i, param->data + param->width * i, param->width);
+
+	param->width = new_width;
+	bind_param_buffer(fmstate, pindex);
+}
+
+/*
+ * Stores a non-null value into the row-th slot of a parameter buffer. Called in the per-batch
+ * temporary context.
+ */
+static void
+set_param_value(TbFdwExecState *fmstate, int pindex, int row, Datum value)
+{
+	TbParamBuffer *param = &fmstate->params[pindex];
+	char *slot = param->data + param->width * row;
+	const char *src;
+	SQLLEN len;
+
+	switch (param->c_type) {
+		case SQL_C_SSHORT:
+			*(int16 *) slot = DatumGetInt16(value);
+			param->ind[row] = param->width;
+			return;
+		case SQL_C_SLONG:
+			*(int32 *) slot = DatumGetInt32(value);
+			param->ind[row] = param->width;
+			return;
+		case SQL_C_SBIGINT:
+			*(int64 *) slot = DatumGetInt64(value);
+			param->ind[row] = param->width;
+			return;
+		case SQL_C_DOUBLE:
+			if (param->pg_type == FLOAT4OID)
+				*(double *) slot = (double) DatumGetFloat4(value);
+			else
+				*(double *) slot = DatumGetFloat8(value);
+			param->ind[row] = param->width;
+			return;
+		case SQL_C_TYPE_TIMESTAMP:
+			if (param->pg_type == DATEOID) {
+				DateADT date = DatumGetDateADT(value);
+
+				if (DATE_NOT_FINITE(date))
+					ereport(ERROR,
+									(errcode(ERRCODE_DATETIME_VALUE_OUT_OF_RANGE),
+									 errmsg("infinite date value cannot be sent to remote table")));
+				/* Dates past the end of timestamps would overflow the conversion below */
+				if (date >= TIMESTAMP_END_JULIAN - POSTGRES_EPOCH_JDATE)
+					ereport(ERROR,
+									(errcode(ERRCODE_DATETIME_VALUE_OUT_OF_RANGE),
+									 errmsg("date out of range for remote table")));
+				timestamp_to_tb_timestamp((Timestamp) date * USECS_PER_DAY, (TIMESTAMP_STRUCT *) slot);
+			} else {
+				timestamp_to_tb_timestamp(DatumGetTimestamp(value), (TIMESTAMP_STRUCT *) slot);
+			}
+			param->ind[row] = param->width;
+			return;
+		case SQL_C_BINARY:
+			{
+				bytea *bytes = DatumGetByteaPP(value);
+
+				src = VARDATA_ANY(bytes);
+				len = VARSIZE_ANY_EXHDR(bytes);
+				break;
+			}
+		default:
+			src = OutputFunctionCall(&param->flinfo, value);
+			len = strlen(src);
+			break;
+	}
+
+	/* Variable length values: text slots also keep the NUL terminator */
+	if (len + (param->c_type == SQL_C_CHAR) > param->width) {
+		grow_param_buffer(fmstate, pindex, len + 1, row);
+		slot = param->data + param->width * row;
+	}
+
+	memcpy(slot, src, len);
+	if (param->c_type == SQL_C_CHAR)
+		slot[len] = '\0';
+	param->ind[row] = len;
+}
+
+static void
+timestamp_to_tb_timestamp(Timestamp ts, TIMESTAMP_STRUCT *tb_ts)
+{
+	struct pg_tm tm;
+	fsec_t fsec;
+
+	if (TIMESTAMP_NOT_FINITE(ts) || timestamp2tm(ts, NULL, &tm, &fsec, NULL, NULL) != 0)
+		ereport(ERROR,
+						(errcode(ERRCODE_DATETIME_VALUE_OUT_OF_RANGE),
+						 errmsg("timestamp out of range for remote table")));
+
+	/* The year is a SQLSMALLINT and would wrap */
+	if (tm.tm_year < PG_INT16_MIN || tm.tm_year > PG_INT16_MAX)
+		ereport(ERROR,
+						(errcode(ERRCODE_DATETIME_VALUE_OUT_OF_RANGE),
+						 errmsg("timestamp out of range for remote table")));
+
+	tb_ts->year = tm.tm_year;
+	tb_ts->month = tm.tm_mon;
+	tb_ts->day = tm.tm_mday;
+	tb_ts->hour = tm.tm_hour;
+	tb_ts->minute = tm.tm_min;
+	tb_ts->second = tm.tm_sec;
+	/* fraction is in nanoseconds */
+	tb_ts->fraction = fsec * 1000;
+}
+
+/*
+ * Sends the rows in the given slots by a single execution of the prepared INSERT statement, and
+ * returns how many of them were inserted.
+ */
+static int
+execute_foreign_insert(TbFdwExecState *fmstate, TupleTableSlot **slots, int num_slots)
+{
+	SQLINTEGER row_cnt = 0;
+	int i;
+
+	Assert(num_slots > 0 && num_slots <= fmstate->batch_size);
+
+	for (i = 0; i < num_slots; i++)
+		store_foreign_row(fmstate, slots[i], NULL, i);
+
+	execute_foreign_modify(fmstate, num_slots);
+
+	if (!fmstate->skip_conflicts)
+		return num_slots;
+
+	/* A row whose key is already there is skipped by the MERGE without an error */
+	TbSQLRowCount(fmstate->tbStmt, &row_cnt);
+
+	return Max(Min(row_cnt, num_slots), 0);
+}
+
+/*
+ * Queues a row to update or delete, and sends the queued rows once batch_size of them are stored.
+ * Returns false if the row was sent alone and no remote row has its ROWID any more.
+ */
+static bool
+queue_foreign_modify(TbFdwExecState *fmstate, TupleTableSlot *slot, TupleTableSlot *planSlot)
+{
+	SQLINTEGER row_cnt = 0;
+
+	store_foreign_row(fmstate, slot, planSlot, fmstate->num_queued++);
+
+	if (fmstate->num_queued < fmstate->batch_size)
+		return true;
+
+	execute_foreign_modify(fmstate, fmstate->num_queued);
+	fmstate->num_queued = 0;
+
+	if (fmstate->batch_size > 1)
+		return true;
+
+	TbSQLRowCount(fmstate->tbStmt, &row_cnt);
+	return row_cnt > 0;
+}
+
+/*
+ * Copies the parameter values of a row into the row-th slots of the parameter buffers. The ROWID of
+ * an updated or deleted row comes from the junk column of the plan slot.
+ */
+static void
+store_foreign_row(TbFdwExecState *fmstate, TupleTableSlot *slot, TupleTableSlot *planSlot, int row)
+{
+	MemoryContext old_context;
+	int pindex;
+
+	old_context = MemoryContextSwitchTo(fmstate->temp_ctx);
+
+	for (pindex = 0; pindex < fmstate->p_nums; pindex++) {
+		TbParamBuffer *param = &fmstate->params[pindex];
+		bool isnull;
+		Datum value;
+
+		if (param->attnum == SelfItemPointerAttributeNumber) {
+			value = ExecGetJunkAttribute(planSlot, fmstate->rowid_attno, &isnull);
+			if (isnull)
+				elog(ERROR, "rowid is NULL");
+		} else {
+			value = slot_getattr(slot, param->attnum, &isnull);
+		}
+
+		if (isnull)
+			param->ind[row] = SQL_NULL_DATA;
+		else
+			set_param_value(fmstate, pindex, row, value);
+	}
+
+	MemoryContextSwitchTo(old_context);
+}
+
+/*
+ * Sends the rows stored in the parameter buffers by a single execution of the prepared statement.
+ * The parameters are bound column-wise in create_foreign_modify, so SQL_ATTR_PARAMSET_SIZE only
+ * tells tbcli how many rows the buffers hold.
+ */
+static void
+execute_foreign_modify(TbFdwExecState *fmstate, int num_rows)
+{
+	int i;
+
+	Assert(num_rows > 0 && num_rows <= fmstate->batch_size);
+
+	if (fmstate->p_set_size != num_rows) {
+		TbSQLSetStmtAttr(fmstate->tbStmt, SQL_ATTR_PARAMSET_SIZE, (SQLPOINTER) (SQLULEN) num_rows, 0);
+		fmstate->p_set_size = num_rows;
+	}
+
+	TbSQLExecute(fmstate->tbStmt);
+
+	/* An array execution succeeds as a whole even if some of the rows failed */
+	for (i = 0; i < fmstate->p_processed; i++) {
+		if (fmstate->p_status[i] == SQL_PARAM_ERROR)
+			ereport(ERROR,
+							(errcode(ERRCODE_FDW_ERROR),
+							 errmsg("failed to %s row %d of %d on remote table",
+											fmstate->operation == CMD_INSERT ? "insert" :
+											fmstate->operation == CMD_UPDATE ? "update" : "delete",
+											i + 1, num_rows)));
+	}
+
+	/*
+	 * A chunked bulk load commits on the remote side once enough rows are sent, trading atomicity of
+	 * the whole load for bounded undo on Tibero. Nothing else was written on the connection before
+	 * the load, so only its rows are committed. The rows of the last chunk are committed with the
+	 * local transaction, so the remote transaction stays open for the rows that follow.
+	 */
+	if (fmstate->commit_size > 0) {
+		fmstate->uncommitted_rows += num_rows;
+		if (fmstate->uncommitted_rows >= fmstate->commit_size) {
+			TbSQLEndTran(fmstate->tbStmt->conn, SQL_COMMIT);
+			fmstate->tbStmt->conn->begin_remote_xact = true;
+			mark_tb_xact_writes(fmstate->tbStmt->conn);
+			fmstate->uncommitted_rows = 0;
+		}
+	}
+
+	MemoryContextReset(fmstate->temp_ctx);
+}
+
+static void
+tiberoEndForeignModify(EState *estate, ResultRelInfo *resultRelInfo)
+{
+	TbFdwExecState *fmstate = (TbFdwExecState *) resultRelInfo->ri_FdwState;
+
+	/* When called for EXPLAIN */
+	if (fmstate == NULL) return;
+
+	set_sleep_on_sig_on();
+
+	/* Send the rows left in a partially filled batch */
+	if (fmstate->num_queued > 0) {
+		execute_foreign_modify(fmstate, fmstate->num_queued);
+		fmstate->num_queued = 0;
+	}
+
+	finish_foreign_modify(fmstate);
+
+	set_sleep_on_sig_off();
+}
+
+/*
+ * Decides whether the modification can run as a single remote statement, so that no row has to pass
+ * through the local server. INSERT ... SELECT qualifies when the source query is one scan of a table
+ * on the target's server whose quals and select list are all shippable. UPDATE and DELETE qualify
+ * when every qual of the scan of the target and every new column value are shippable; otherwise the
+ * rows are modified one by one through their ROWIDs.
+ */
+static bool
+tiberoPlanDirectModify(PlannerInfo *root, ModifyTable *plan, Index resultRelation,
+											 int subplan_index)
+{
+	CmdType operation = plan->operation;
+	RangeTblEntry *rte = planner_rt_fetch(resultRelation, root);
+	Plan *subplan = outerPlan(plan);
+	ForeignScan *fscan;
+	RelOptInfo *foreignrel;
+	TbFdwRelationInfo *fpinfo;
+	Relation rel;
+	List *targetAttrs = NIL;
+	List *exprs = NIL;
+	StringInfoData sql;
+	ListCell *lc;
+
+	if (operation != CMD_INSERT && operation != CMD_UPDATE && operation != CMD_DELETE)
+		return false;
+
+	if (plan->returningLists != NIL || plan->onConflictAction != ONCONFLICT_NONE)
+		return false;
+
+	if (subplan == NULL || !IsA(subplan, ForeignScan))
+		return false;
+
+	fscan = (ForeignScan *) subplan;
+	if (fscan->scan.scanrelid == 0 || fscan->scan.plan.qual != NIL || fscan->fdw_exprs != NIL)
+		return false;
+
+	if (operation == CMD_INSERT) {
+		/* Both tables must be reached through the same connection */
+		if (fscan->fs_server != GetForeignTable(rte->relid)->serverid ||
+				get_rte_check_as_user(root, fscan->scan.scanrelid) !=
+				get_rte_check_as_user(root, resultRelation))
+			return false;
+
+		foreignrel = find_base_rel(root, fscan->scan.scanrelid);
+
+		foreach(lc, fscan->scan.plan.targetlist) {
+			TargetEntry *tle = lfirst_node(TargetEntry, lc);
+			Expr *expr = tle->expr;
+			HeapTuple atttup;
+
+			if (tle->resjunk)
+				return false;
+
+			/* A dropped column is filled with a null by the planner and has no remote column */
+			atttup = SearchSysCacheAttNum(rte->relid, tle->resno);
+			if (atttup == NULL)
+				continue;
+			ReleaseSysCache(atttup);
+
+			/* Binary compatible coercions are left to the implicit conversion of Tibero */
+			while (IsA(expr, RelabelType))
+				expr = ((RelabelType *) expr)->arg;
+
+			if (!expr_inspect_shippability(root, foreignrel, expr))
+				return false;
+
+			targetAttrs = lappend_int(targetAttrs, tle->resno);
+			exprs = lappend(exprs, expr);
+		}
+	} else {
+		/* The scan must be of the target table itself */
+		if (fscan->scan.scanrelid != resultRelation)
+			return false;
+
+		foreignrel = find_base_rel(root, resultRelation);
+
+		if (operation == CMD_UPDATE) {
+			List *processed_tlist;
+			ListCell *lc2;
+
+			/* The new values of the changed columns, in the order of their attribute numbers */
+			get_translated_update_targetlist(root, resultRelation, &processed_tlist, &targetAttrs);
+
+			forboth(lc, processed_tlist, lc2, targetAttrs) {
+				TargetEntry *tle = lfirst_node(TargetEntry, lc);
+				Expr *expr = tle->expr;
+
+				if (lfirst_int(lc2) <= InvalidAttrNumber)
+					elog(ERROR, "system-column update is not supported");
+
+				while (IsA(expr, RelabelType))
+					expr = ((RelabelType *) expr)->arg;
+
+				if (!expr_inspect_shippability(root, foreignrel, expr))
+					return false;
+
+				exprs = lappend(exprs, expr);
+			}
+		}
+	}
+
+	fpinfo = (TbFdwRelationInfo *) foreignrel->fdw_private;
+
+	set_sleep_on_sig_on();
+
+	rel = table_open(rte->relid, NoLock);
+
+	initStringInfo(&sql);
+	switch (operation) {
+		case CMD_INSERT:
+			deparse_direct_insert_sql(&sql, root, resultRelation, rel, foreignrel, targetAttrs, exprs,
+																fpinfo->final_remote_exprs);
+			break;
+		case CMD_UPDATE:
+			deparse_direct_update_sql(&sql, root, resultRelation, rel, foreignrel, targetAttrs, exprs,
+																fpinfo->final_remote_exprs);
+			break;
+		case CMD_DELETE:
+			deparse_direct_delete_sql(&sql, root, resultRelation, rel, foreignrel,
+																fpinfo->final_remote_exprs);
+			break;
+		default:
+			elog(ERROR, "unexpected operation: %d", (int) operation);
+			break;
+	}
+
+	table_close(rel, NoLock);
+
+	fscan->operation = operation;
+	fscan->resultRelation = resultRelation;
+	fscan->fdw_private = list_make2(makeString(sql.data), makeInteger(plan->canSetTag));
+
+	set_sleep_on_sig_off();
+
+	return true;
+}
+
+static void
+tiberoBeginDirectModify(ForeignScanState *node, int eflags)
+{
+	ForeignScan *fsplan = (ForeignScan *) node->ss.ps.plan;
+	EState *estate = node->ss.ps.state;
+	Relation rel = node->resultRelInfo->ri_RelationDesc;
+	TbFdwDirectModifyState *dmstate;
+	ForeignTable *table;
+	UserMapping *user;
+	Oid userid;
+#if PG_VERSION_NUM < 160000
+	RangeTblEntry *rte;
+#endif
+
+	if (eflags & EXEC_FLAG_EXPLAIN_ONLY)
+		return;
+
+	set_sleep_on_sig_on();
+
+#if PG_VERSION_NUM >= 160000
+	userid = (fsplan->checkAsUser != InvalidOid) ? fsplan->checkAsUser : GetUserId();
+#else
+	rte = exec_rt_fetch(node->resultRelInfo->ri_RangeTableIndex, estate);
+	userid = (rte->checkAsUser != InvalidOid) ? rte->checkAsUser : GetUserId();
+#endif
+
+	table = GetForeignTable(RelationGetRelid(rel));
+	user = GetUserMapping(userid, table->serverid);
+
+	dmstate = (TbFdwDirectModifyState *) palloc0(sizeof(TbFdwDirectModifyState));
+	dmstate->query = strVal(list_nth(fsplan->fdw_private, TbFdwDirectModifyQuery));
+	dmstate->set_processed = intVal(list_nth(fsplan->fdw_private, TbFdwDirectModifySetProcessed));
+
+	dmstate->tbStmt = (TbStatement *) palloc0(sizeof(TbStatement));
+	get_tb_statement(user, dmstate->tbStmt, false);
+	mark_tb_xact_writes(dmstate->tbStmt->conn);
+
+	node->fdw_state = (void *) dmstate;
+
+	set_sleep_on_sig_off();
+}
+
+static TupleTableSlot *
+tiberoIterateDirectModify(ForeignScanState *node)
+{
+	TbFdwDirectModifyState *dmstate = (TbFdwDirectModifyState *) node->fdw_state;
+	EState *estate = node->ss.ps.state;
+	Instrumentation *instr = node->ss.ps.instrument;
+
+	if (!dmstate->executed) {
+		SQLINTEGER row_cnt = 0;
+
+		set_sleep_on_sig_on();
+
+		TbSQLExecDirect(dmstate->tbStmt, (SQLCHAR *) dmstate->query, SQL_NTS);
+		TbSQLRowCount(dmstate->tbStmt, &row_cnt);
+
+		dmstate->num_tuples = row_cnt;
+		dmstate->executed = true;
+
+		if (dmstate->set_processed)
+			estate->es_processed += dmstate->num_tuples;
+
+		if (instr)
+			instr->tuplecount += dmstate->num_tuples;
+
+		set_sleep_on_sig_off();
+	}
+
+	/* Without RETURNING no row is handed back to the ModifyTable node */
+	return ExecClearTuple(node->ss.ss_ScanTupleSlot);
+}
+
+static void
+tiberoEndDirectModify(ForeignScanState *node)
+{
+	TbFdwDirectModifyState *dmstate = (TbFdwDirectModifyState *) node->fdw_state;
+
+	/* When called for EXPLAIN */
+	if (dmstate == NULL) return;
+
+	set_sleep_on_sig_on();
+
+	release_tb_statement(dmstate->tbStmt);
+
+	set_sleep_on_sig_off();
+}
+
+static void
+tiberoExplainDirectModify(ForeignScanState *node, ExplainState *es)
+{
+	List *fdw_private = ((ForeignScan *) node->ss.ps.plan)->fdw_private;
+
+	/* Add remote query when VERBOSE option is specified */
+	if (es->verbose)
+	{
+		char *sql = strVal(list_nth(fdw_private, TbFdwDirectModifyQuery));
+		ExplainPropertyText("Remote SQL", sql, es);
+	}
+}
+
+/*
+ * Truncates the remote tables of the given foreign tables, which all belong to one server and are
+ * reached through the connection of the current user. Tibero truncates a table per statement, so
+ * the statements are made first and checked against the truncatable option of every table before
+ * any of them is run.
+ *
+ * TRUNCATE is DDL on Tibero and commits the remote transaction, so it cannot be rolled back along
+ * with the local transaction. It would commit the earlier writes of the transaction on the same
+ * connection as well, so it is refused once there are any. RESTRICT is what Tibero does by default, refusing to truncate a table
+ * referenced by an enabled foreign key. Tibero sequences are not owned by tables, so RESTART
+ * IDENTITY has nothing to restart.
+ */
+static void
+tiberoExecForeignTruncate(List *rels, DropBehavior behavior, bool restart_seqs)
+{
+	Oid serverid = InvalidOid;
+	UserMapping *user;
+	TbStatement *tbStmt;
+	ConnCacheEntry *conn;
+	List *queries = NIL;
+	ListCell *lc;
+
+	if (behavior == DROP_CASCADE)
+		ereport(ERROR,
+						(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+						 errmsg("TRUNCATE ... CASCADE is not supported for tibero_fdw")));
+
+	set_sleep_on_sig_on();
+
+	foreach(lc, rels) {
+		Relation rel = (Relation) lfirst(lc);
+		ForeignTable *table = GetForeignTable(RelationGetRelid(rel));
+		ForeignServer *server = GetForeignServer(table->serverid);
+		bool truncatable = true;
+		StringInfoData sql;
+		ListCell *cell;
+
+		Assert(!OidIsValid(serverid) || serverid == table->serverid);
+		serverid = table->serverid;
+
+		foreach(cell, server->options) {
+			DefElem *def = (DefElem *) lfirst(cell);
+			if (strcmp(def->defname, "truncatable") == 0)
+				truncatable = defGetBoolean(def);
+		}
+
+		foreach(cell, table->options) {
+			DefElem *def = (DefElem *) lfirst(cell);
+			if (strcmp(def->defname, "truncatable") == 0)
+				truncatable = defGetBoolean(def);
+		}
+
+		if (!truncatable)
+			ereport(ERROR,
+							(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+							 errmsg("foreign table \"%s\" does not allow truncates",
+											RelationGetRelationName(rel))));
+
+		initStringInfo(&sql);
+		deparse_truncate_sql(&sql, rel);
+		queries = lappend(queries, sql.data);
+	}
+
+	if (queries == NIL) {
+		set_sleep_on_sig_off();
+		return;
+	}
+
+	user = GetUserMapping(GetUserId(), serverid);
+
+	tbStmt = (TbStatement *) palloc0(sizeof(TbStatement));
+	get_tb_statement(user, tbStmt, false);
+
+	conn = tbStmt->conn;
+
+	if (conn->xact_writes) {
+		release_tb_statement(tbStmt);
+		ereport(ERROR,
+						(errcode(ERRCODE_ACTIVE_SQL_TRANSACTION),
+						 errmsg("cannot truncate a foreign table after writes to server \"%s\" in the same transaction",
+										conn->servername),
+						 errhint("Run TRUNCATE in a transaction of its own, as it commits the remote transaction.")));
+	}
+
+	/* Each TRUNCATE commits on its own, so it leaves no write for the transaction to end */
+	foreach(lc, queries)
+		TbSQLExecDirect(tbStmt, (SQLCHAR *) lfirst(lc), SQL_NTS);
+
+	release_tb_statement(tbStmt);
+
+	set_sleep_on_sig_off();
+}
+
+static Oid
+get_rte_check_as_user(PlannerInfo *root, Index rtindex)
+{
+	RangeTblEntry *rte = planner_rt_fetch(rtindex, root);
+
+#if PG_VERSION_NUM >= 160000
+	return getRTEPermissionInfo(root->parse->rteperminfos, rte)->checkAsUser;
+#else
+	return rte->checkAsUser;
+#endif
+}
+
+typedef struct TbImportColumns
+{
+	SQLCHAR (*table_name)[TB_MAXLEN_SQLID_WITH_NULL];
+	SQLCHAR (*column_name)[TB_MAXLEN_SQLID_WITH_NULL];
+	SQLCHAR (*data_type)[TB_MAXLEN_TYPENAME_WITH_NULL];
+	SQLINTEGER *precision;
+	SQLINTEGER *scale;
+	SQLINTEGER *char_length;
+	SQLCHAR (*nullable)[2];
+	SQLCHAR (*is_key)[2];
+	SQLLEN *ind[8];
+} TbImportColumns;
+
+static List *
+tiberoImportForeignSchema(ImportForeignSchemaStmt *stmt, Oid serverOid)
+{
+	List *commands = NIL;
+	bool import_not_null = true;
+	ForeignServer *server;
+	UserMapping *user;
+	TbStatement *tbStmt;
+	TbImportColumns cols;
+	StringInfoData sql;
+	StringInfoData cmd;
+	SQLULEN fetched_cnt = 0;
+	bool end_of_fetch = false;
+	char prev_table_name[TB_MAXLEN_SQLID_WITH_NULL] = {0,};
+	char *remote_schema;
+	int i;
+	ListCell *lc;
+
+	foreach(lc, stmt->options) {
+		DefElem *def = (DefElem *) lfirst(lc);
+
+		if (strcmp(def->defname, "import_not_null") == 0)
+			import_not_null = defGetBoolean(def);
+		else
+			ereport(ERROR,
+							(errcode(ERRCODE_FDW_INVALID_OPTION_NAME),
+							 errmsg("invalid option \"%s\"", def->defname),
+							 errhint("Valid options in this context are: import_not_null")));
+	}
+
+	set_sleep_on_sig_on();
+
+	server = GetForeignServer(serverOid);
+	user = GetUserMapping(GetUserId(), server->serverid);
+
+	remote_schema = fold_local_name(stmt->remote_schema);
+
+	initStringInfo(&sql);
+	deparse_import_schema_sql(&sql, stmt, remote_schema);
+
+	tbStmt = (TbStatement *) palloc0(sizeof(TbStatement));
+	get_tb_statement(user, tbStmt, false);
+
+	/* Column buffers are bound once and reused for every block of the array fetch */
+	cols.table_name = palloc0(sizeof(*cols.table_name) * TB_FDW_IMPORT_FETCH_SIZE);
+	cols.column_name = palloc0(sizeof(*cols.column_name) * TB_FDW_IMPORT_FETCH_SIZE);
+	cols.data_type = palloc0(sizeof(*cols.data_type) * TB_FDW_IMPORT_FETCH_SIZE);
+	cols.precision = palloc0(sizeof(SQLINTEGER) * TB_FDW_IMPORT_FETCH_SIZE);
+	cols.scale = palloc0(sizeof(SQLINTEGER) * TB_FDW_IMPORT_FETCH_SIZE);
+	cols.char_length = palloc0(sizeof(SQLINTEGER) * TB_FDW_IMPORT_FETCH_SIZE);
+	cols.nullable = palloc0(sizeof(*cols.nullable) * TB_FDW_IMPORT_FETCH_SIZE);
+	cols.is_key = palloc0(sizeof(*cols.is_key) * TB_FDW_IMPORT_FETCH_SIZE);
+	for (i = 0; i < lengthof(cols.ind); i++)
+		cols.ind[i] = palloc0(sizeof(SQLLEN) * TB_FDW_IMPORT_FETCH_SIZE);
+
+	TbSQLExecDirect(tbStmt, (SQLCHAR *) sql.data, SQL_NTS);
+
+	TbSQLSetStmtAttr(tbStmt, SQL_ATTR_ROW_ARRAY_SIZE, (SQLPOINTER) TB_FDW_IMPORT_FETCH_SIZE, 0);
+	TbSQLSetStmtAttr(tbStmt, SQL_ATTR_ROWS_FETCHED_PTR, (SQLPOINTER) &fetched_cnt, 0);
+
+	TbSQLBindCol(tbStmt, 1, SQL_C_CHAR, cols.table_name, sizeof(*cols.table_name), cols.ind[0]);
+	TbSQLBindCol(tbStmt, 2, SQL_C_CHAR, cols.column_name, sizeof(*cols.column_name), cols.ind[1]);
+	TbSQLBindCol(tbStmt, 3, SQL_C_CHAR, cols.data_type, sizeof(*cols.data_type), cols.ind[2]);
+	TbSQLBindCol(tbStmt, 4, SQL_C_SLONG, cols.precision, sizeof(SQLINTEGER), cols.ind[3]);
+	TbSQLBindCol(tbStmt, 5, SQL_C_SLONG, cols.scale, sizeof(SQLINTEGER), cols.ind[4]);
+	TbSQLBindCol(tbStmt, 6, SQL_C_SLONG, cols.char_length, sizeof(SQLINTEGER), cols.ind[5]);
+	TbSQLBindCol(tbStmt, 7, SQL_C_CHAR, cols.nullable, sizeof(*cols.nullable), cols.ind[6]);
+	TbSQLBindCol(tbStmt, 8, SQL_C_CHAR, cols.is_key, sizeof(*cols.is_key), cols.ind[7]);
+
+	initStringInfo(&cmd);
+
+	for (;;) {
+		TbSQLFetch(tbStmt, NULL, &end_of_fetch);
+		if (end_of_fetch)
+			break;
+
+		for (i = 0; i < fetched_cnt; i++) {
+			char *table_name = (char *) cols.table_name[i];
+			char *column_name = (char *) cols.column_name[i];
+
+			if (strcmp(table_name, prev_table_name) != 0) {
+				if (cmd.len > 0) {
+					appendStringInfo(&cmd, "\n) SERVER %s OPTIONS (owner_name %s, table_name %s)",
+													 quote_identifier(server->servername),
+													 quote_literal_cstr(remote_schema),
+													 quote_literal_cstr(prev_table_name));
+					commands = lappend(commands, pstrdup(cmd.data));
+					resetStringInfo(&cmd);
+				}
+
+				appendStringInfo(&cmd, "CREATE FOREIGN TABLE %s (\n",
+												 quote_identifier(fold_remote_name(table_name)));
+				strlcpy(prev_table_name, table_name, sizeof(prev_table_name));
+			} else {
+				appendStringInfoString(&cmd, ",\n");
+			}
+
+			appendStringInfo(&cmd, "  %s ", quote_identifier(fold_remote_name(column_name)));
+			append_pg_type_for_tb_type(&cmd, (char *) cols.data_type[i],
+																 cols.precision[i], cols.ind[3][i] != SQL_NULL_DATA,
+																 cols.scale[i], cols.ind[4][i] != SQL_NULL_DATA,
+																 cols.ind[5][i] != SQL_NULL_DATA ? cols.char_length[i] : 0);
+			/* Primary key columns are marked as keys for ON CONFLICT DO NOTHING */
+			appendStringInfo(&cmd, " OPTIONS (column_name %s%s)", quote_literal_cstr(column_name),
+											 cols.is_key[i][0] == 'Y' ? ", key 'true'" : "");
+
+			if (import_not_null && cols.nullable[i][0] == 'N')
+				appendStringInfoString(&cmd, " NOT NULL");
+		}
+	}
+
+	if (cmd.len > 0) {
+		appendStringInfo(&cmd, "\n) SERVER %s OPTIONS (owner_name %s, table_name %s)",
+										 quote_identifier(server->servername),
+										 quote_literal_cstr(remote_schema),
+										 quote_literal_cstr(prev_table_name));
+		commands = lappend(commands, pstrdup(cmd.data));
+	}
+
+	release_tb_statement(tbStmt);
+
+	set_sleep_on_sig_off();
+
+	return commands;
+}
+
+/*
+ * Tibero stores unquoted identifiers in upper case. Such names are folded to lower case so that the
+ * imported objects can be referenced without quoting; mixed case names are kept as they are.
+ */
+static char *
+fold_remote_name(const char *remote_name)
+{
+	char *local_name = pstrdup(remote_name);
+	char *ptr;
+
+	for (ptr = local_name; *ptr; ptr++) {
+		if (*ptr >= 'a' && *ptr <= 'z')
+			return local_name;
+	}
+
+	for (ptr = local_name; *ptr; ptr++)
+		*ptr = pg_ascii_tolower((unsigned char) *ptr);
+
+	return local_name;
+}
+
+/*
+ * Names given in lower case, as unquoted names are kept by PostgreSQL, are folded to upper case as
+ * Tibero stores them; mixed case names are kept as they are.
+ */
+static char *
+fold_local_name(const char *local_name)
+{
+	char *remote_name = pstrdup(local_name);
+	char *ptr;
+
+	for (ptr = remote_name; *ptr; ptr++) {
+		if (*ptr >= 'A' && *ptr <= 'Z')
+			return remote_name;
+	}
+
+	for (ptr = remote_name; *ptr; ptr++)
+		*ptr = pg_ascii_toupper((unsigned char) *ptr);
+
+	return remote_name;
+}
+
+static void
+append_pg_type_for_tb_type(StringInfo buf, const char *tb_type, SQLINTEGER precision,
+													 bool has_precision, SQLINTEGER scale, bool has_scale,
+													 SQLINTEGER char_length)
+{
+	if (strcmp(tb_type, "NUMBER") == 0) {
+		if (!has_precision) {
+			appendStringInfoString(buf, "numeric");
+		} else if (has_scale && scale == 0 && precision <= 4) {
+			appendStringInfoString(buf, "smallint");
+		} else if (has_scale && scale == 0 && precision <= 9) {
+			appendStringInfoString(buf, "integer");
+		} else if (has_scale && scale == 0 && precision <= 18) {
+			appendStringInfoString(buf, "bigint");
+		} else if (has_scale && scale >= 0 && scale <= precision) {
+			appendStringInfo(buf, "numeric(%d,%d)", (int) precision, (int) scale);
+		} else {
+			appendStringInfoString(buf, "numeric");
+		}
+	} else if (strcmp(tb_type, "FLOAT") == 0 || strcmp(tb_type, "BINARY_DOUBLE") == 0) {
+		appendStringInfoString(buf, "double precision");
+	} else if (strcmp(tb_type, "BINARY_FLOAT") == 0) {
+		appendStringInfoString(buf, "real");
+	} else if (strcmp(tb_type, "CHAR") == 0 || strcmp(tb_type, "NCHAR") == 0) {
+		if (char_length > 0)
+			appendStringInfo(buf, "character(%d)", (int) char_length);
+		else
+			appendStringInfoString(buf, "character");
+	} else if (strcmp(tb_type, "VARCHAR") == 0 || strcmp(tb_type, "VARCHAR2") == 0 ||
+						 strcmp(tb_type, "NVARCHAR") == 0 || strcmp(tb_type, "NVARCHAR2") == 0) {
+		if (char_length > 0)
+			appendStringInfo(buf, "character varying(%d)", (int) char_length);
+		else
+			appendStringInfoString(buf, "character varying");
+	} else if (strcmp(tb_type, "DATE") == 0) {
+		/* Tibero DATE keeps the time of day down to seconds */
+		appendStringInfoString(buf, "timestamp(0) without time zone");
+	} else if (strcmp(tb_type, "TIME") == 0) {
+		appendStringInfoString(buf, "time without time zone");
+	} else if (strncmp(tb_type, "TIMESTAMP", strlen("TIMESTAMP")) == 0) {
+		int fsec_precision = has_scale ? Min((int) scale, MAX_TIMESTAMP_PRECISION) : 6;
+
+		if (strstr(tb_type, "TIME ZONE") != NULL)
+			appendStringInfo(buf, "timestamp(%d) with time zone", fsec_precision);
+		else
+			appendStringInfo(buf, "timestamp(%d) without time zone", fsec_precision);
+	} else if (strncmp(tb_type, "INTERVAL YEAR", strlen("INTERVAL YEAR")) == 0) {
+		appendStringInfoString(buf, "interval year to month");
+	} else if (strncmp(tb_type, "INTERVAL DAY", strlen("INTERVAL DAY")) == 0) {
+		int fsec_precision = has_scale ? Min((int) scale, MAX_INTERVAL_PRECISION) : 6;
+
+		appendStringInfo(buf, "interval day to second(%d)", fsec_precision);
+	} else if (strcmp(tb_type, "RAW") == 0 || strcmp(tb_type, "LONG RAW") == 0 ||
+						 strcmp(tb_type, "BLOB") == 0) {
+		appendStringInfoString(buf, "bytea");
+	} else {
+		/* CLOB, NCLOB, LONG, ROWID and anything not listed above are read as text */
+		appendStringInfoString(buf, "text");
+	}
 }
@@ -15,12 +15,19 @@
 
 #include "foreign/foreign.h"											/* ForeignServer, ForeignTable									*/
 #include "lib/stringinfo.h"						  					/* StringInfo                         					*/
+#include "nodes/parsenodes.h"										/* ImportForeignSchemaStmt											*/
 #include "nodes/pathnodes.h"											/* PlannerInfo, RelOptInfo											*/
 #include "utils/rel.h"														/* Relation																			*/
 
 #include "sqlcli.h"
 #include "sqlcli_types.h"
 
+/* Endpoints listed by each of the hosts and standby_hosts options, and by a server in all */
+#define TB_FDW_MAX_HOSTS 16
+#define TB_FDW_MAX_ENDPOINTS (1 + 2 * TB_FDW_MAX_HOSTS)
+#define TB_ENDPOINT_HOST_LEN 256
+#define TB_ENDPOINT_PORT_LEN 16
+
 typedef struct TbFdwRelationInfo
 {
 	bool pushdown_safe;
@@ -76,8 +83,45 @@ extern void deparse_select_stmt_for_rel(StringInfo buf, PlannerInfo *root, RelOp
 																				bool has_final_sort, bool has_limit, bool is_subquery,
 																				List **retrieved_attrs, List **params_list,
 																				bool use_fb_query);
-extern void deparse_insert_sql(StringInfo buf, PlannerInfo *root, Index rtindex, Relation rel,
+extern void deparse_insert_sql(StringInfo buf, RangeTblEntry *rte, Index rtindex, Relation rel,
+															 List *targetAttrs, bool bulk_load);
+extern void deparse_merge_insert_sql(StringInfo buf, RangeTblEntry *rte, Index rtindex,
+																		 Relation rel, List *targetAttrs, List *keyAttrs);
+extern void deparse_update_sql(StringInfo buf, RangeTblEntry *rte, Index rtindex, Relation rel,
 															 List *targetAttrs);
+extern void deparse_delete_sql(StringInfo buf, Relation rel);
+extern void deparse_direct_insert_sql(StringInfo buf, PlannerInfo *root, Index rtindex,
+																			Relation rel, RelOptInfo *foreignrel, List *targetAttrs,
+																			List *exprs, List *remote_conds);
+extern void deparse_direct_update_sql(StringInfo buf, PlannerInfo *root, Index rtindex,
+																			Relation rel, RelOptInfo *foreignrel, List *targetAttrs,
+																			List *exprs, List *remote_conds);
+extern void deparse_direct_delete_sql(StringInfo buf, PlannerInfo *root, Index rtindex,
+																			Relation rel, RelOptInfo *foreignrel, List *remote_conds);
+extern void deparse_truncate_sql(StringInfo buf, Relation rel);
+extern void deparse_import_schema_sql(StringInfo buf, ImportForeignSchemaStmt *stmt,
+																			const char *remote_schema);
+
+/* in option.c */
+extern bool parse_tb_endpoints(const char *value, List **hosts, List **ports);
+
+/* in shmem.c */
+extern void init_tb_shmem(void);
+extern bool acquire_tb_session(Oid serverid, const char *servername, bool wait, bool *counted);
+extern bool tb_session_limit_reached(Oid serverid);
+extern void release_tb_session(Oid serverid);
+extern bool acquire_tb_query_slot(Oid serverid, const char *servername, int max_queries,
+																	int queue_timeout);
+extern void release_tb_query_slot(Oid serverid);
+extern void release_tb_query_slots(void);
+extern bool check_tb_circuit(Oid serverid, const char *servername, int max_failures,
+														 int cooldown, bool raise_error);
+extern void report_tb_connect_result(Oid serverid, bool succeeded, int max_failures,
+																		 int cooldown);
+extern int next_tb_endpoint(Oid serverid);
+extern bool get_tb_endpoint_sessions(Oid serverid, int *sessions);
+extern bool add_tb_endpoint_session(Oid serverid, int endpoint);
+extern void remove_tb_endpoint_session(Oid serverid, int endpoint);
 
 /* in utils.c */
 extern void register_signal_handlers(void);